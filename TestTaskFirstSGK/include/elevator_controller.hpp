@@ -5,12 +5,18 @@
  */
 
 #pragma once
+#include <concepts>
+#include <cstddef>
 #include <cstdint>
 #include <expected>
+#include <optional>
+#include <span>
 #include <string>
-#include <unordered_set>
+#include <vector>
 
 #include "direction.hpp"
+#include "floor_set.hpp"
+#include "scheduling_policy.hpp"
 
 namespace elevator {
 
@@ -19,30 +25,91 @@ namespace elevator {
  * @brief Errors that can occur during elevator operation.
  *
  * @var ElevatorError::InvalidFloor
- *      Requested floor is outside valid range (1-9).
+ *      Requested floor is outside the building's floor range.
+ * @var ElevatorError::InvalidCar
+ *      Requested car is not part of the group.
  */
-enum class ElevatorError : uint8_t { InvalidFloor };
+enum class ElevatorError : uint8_t { InvalidFloor, InvalidCar };
 
 /**
  * @brief Generates a human-readable error message for ElevatorError.
  * @param error The error type.
  * @param floor The invalid floor (if applicable).
+ * @param min_floor Lowest floor of the building.
+ * @param max_floor Highest floor of the building.
  * @return Descriptive error string.
  */
-std::string make_error_message(ElevatorError error, int floor);
+std::string make_error_message(ElevatorError error, int floor, int min_floor,
+                               int max_floor);
+
+/**
+ * @struct Request
+ * @brief One request of a batch passed to addRequests().
+ */
+struct Request {
+  enum class Kind : uint8_t { Internal, External };
+
+  Kind kind = Kind::Internal;             ///< Passenger input or hall call.
+  int floor = 0;                          ///< Requested floor.
+  Direction direction = Direction::IDLE;  ///< Hall-call direction.
+};
+
+/**
+ * @struct RequestBatchResult
+ * @brief Outcome of addRequests(): which requests of the batch failed.
+ *
+ * Failures are kept as a bitmask, one bit per request, that stays empty
+ * (and unallocated) while every request succeeds.
+ */
+struct RequestBatchResult {
+  size_t accepted = 0;            ///< Requests added.
+  std::vector<uint64_t> rejected;  ///< Bit i set if request i failed.
+
+  /// @return Error of the request with the given index, if it failed.
+  [[nodiscard]] std::optional<ElevatorError> error(
+      size_t index) const noexcept {
+    const size_t word = index / 64;
+    if (word >= rejected.size() ||
+        ((rejected[word] >> (index % 64)) & 1) == 0) {
+      return std::nullopt;
+    }
+    return ElevatorError::InvalidFloor;
+  }
+};
 
 /**
- * @class ElevatorController
+ * @class BasicElevatorController
  * @brief Manages elevator state, requests, and movement logic.
+ * @tparam MinFloor Lowest floor of the building.
+ * @tparam MaxFloor Highest floor of the building.
+ * @tparam Policy SchedulingPolicy choosing the direction (LOOK by default).
+ *
+ * The building height is fixed at compile time, so the request sets use the
+ * tightest FloorSet storage and floor checks fold into constants. The policy
+ * is called statically from updateDirection(), so it inlines into move().
  */
-class ElevatorController {
+template <int MinFloor, int MaxFloor, typename Policy = LookPolicy>
+class BasicElevatorController {
+  static_assert(MinFloor <= MaxFloor, "MinFloor must not exceed MaxFloor");
+  static_assert(SchedulingPolicy<Policy, MaxFloor - MinFloor + 1>,
+                "Policy must provide nextDirection(), see SchedulingPolicy");
+
  public:
-  ElevatorController() noexcept = default;
-  ~ElevatorController() = default;
+  // Constants for floor bounds.
+  static constexpr int kMinFloor = MinFloor;  ///< Minimum valid floor.
+  static constexpr int kMaxFloor = MaxFloor;  ///< Maximum valid floor.
+  /// Number of floors served.
+  static constexpr int kFloorCount = kMaxFloor - kMinFloor + 1;
+
+  /// Per-floor request bits, index 0 is kMinFloor.
+  using Requests = FloorSet<kFloorCount>;
+
+  BasicElevatorController() noexcept = default;
+  ~BasicElevatorController() = default;
 
   /**
    * @brief Adds a request from inside the elevator (passenger input).
-   * @param floor Target floor (1-9).
+   * @param floor Target floor (kMinFloor-kMaxFloor).
    * @return std::expected<void, ElevatorError>
    *         - Success: void
    *         - Failure: ElevatorError with details.
@@ -52,13 +119,28 @@ class ElevatorController {
 
   /**
    * @brief Adds a request from outside the elevator (hall call).
-   * @param floor Requested floor (1-9).
+   * @param floor Requested floor (kMinFloor-kMaxFloor).
+   * @param direction Button pressed: UP or DOWN, or IDLE for a call without
+   *        a direction.
    * @return std::expected<void, ElevatorError>
    *         - Success: void
    *         - Failure: ElevatorError with details.
+   * @note A directional call is served when the car leaves the floor in
+   *       that direction, or turns around or parks there. A car passing the
+   *       floor the other way picks it up on the return sweep.
    */
   [[nodiscard]] std::expected<void, ElevatorError> addExternalRequest(
-      int floor);
+      int floor, Direction direction = Direction::IDLE);
+
+  /**
+   * @brief Adds a batch of requests, recomputing the direction once.
+   * @param requests Requests to add; invalid ones are skipped.
+   * @return Which requests failed, see RequestBatchResult.
+   * @note The direction is chosen as if the whole batch arrived at once,
+   *       which may differ from adding the requests one by one.
+   */
+  [[nodiscard]] RequestBatchResult addRequests(
+      std::span<const Request> requests);
 
   /**
    * @brief Moves the elevator one floor in the current direction.
@@ -66,7 +148,22 @@ class ElevatorController {
    */
   void move();
 
-  /// @return Current floor (1-9).
+  /**
+   * @brief Floor where the car will next serve a request.
+   * @return The floor repeated move() calls stop at first, if the car has
+   *         requests.
+   */
+  [[nodiscard]] std::optional<int> nextStop() const noexcept;
+
+  /**
+   * @brief Moves the car straight to nextStop().
+   * @return Number of floors travelled; 0 if the car has no requests.
+   * @note Leaves the car in the same state as calling move() until it
+   *       stops, but in constant time.
+   */
+  int advanceToNextStop() noexcept;
+
+  /// @return Current floor (kMinFloor-kMaxFloor).
   [[nodiscard]] int getCurrentFloor() const noexcept { return current_floor_; }
 
   /// @return Current movement direction (UP/DOWN/IDLE).
@@ -77,28 +174,337 @@ class ElevatorController {
   /// @return True if there are pending requests.
   [[nodiscard]] bool hasRequests() const noexcept;
 
-  // Constants for floor bounds.
-  static constexpr int kMinFloor = 1;  ///< Minimum valid floor.
-  static constexpr int kMaxFloor = 9;  ///< Maximum valid floor.
+  /// @return Every floor the car still has to visit.
+  [[nodiscard]] Requests pendingFloors() const noexcept {
+    return pendingRequests();
+  }
+
+  /**
+   * @brief Withdraws a hall call, e.g. when a dispatcher hands it to another
+   * car.
+   * @param floor Floor of the hall call; invalid floors are ignored.
+   * @param direction Direction the call was added with.
+   */
+  void cancelExternalRequest(int floor,
+                             Direction direction = Direction::IDLE) noexcept;
+
+  /// @return True if a hall call for the floor and direction is pending.
+  [[nodiscard]] bool hasExternalRequest(
+      int floor, Direction direction = Direction::IDLE) const noexcept;
+
+  /// @return Number of distinct floors the car still has to stop at.
+  [[nodiscard]] int pendingStopCount() const noexcept;
+
+  /// @return Highest requested floor, if any.
+  [[nodiscard]] std::optional<int> highestRequest() const noexcept;
+
+  /// @return Lowest requested floor, if any.
+  [[nodiscard]] std::optional<int> lowestRequest() const noexcept;
+
+  /**
+   * @brief Generates a human-readable error message with this building's
+   * floor bounds.
+   * @param error The error type.
+   * @param floor The invalid floor (if applicable).
+   * @return Descriptive error string.
+   */
+  [[nodiscard]] static std::string errorMessage(ElevatorError error,
+                                                int floor) {
+    return make_error_message(error, floor, kMinFloor, kMaxFloor);
+  }
 
  private:
-  int current_floor_{kMinFloor};               ///< Current floor position.
-  Direction direction_{Direction::IDLE};       ///< Current movement direction.
-  std::unordered_set<int> internal_requests_;  ///< Passenger-selected floors.
-  std::unordered_set<int> external_requests_;  ///< Hall-call requests.
+  int current_floor_{kMinFloor};          ///< Current floor position.
+  Direction direction_{Direction::IDLE};  ///< Current movement direction.
+  Requests internal_requests_;            ///< Passenger-selected floors.
+  Requests external_requests_;            ///< Hall calls without direction.
+  Requests up_calls_;                     ///< Hall calls going up.
+  Requests down_calls_;                   ///< Hall calls going down.
 
-  // Validates a floor number (1-9).
+  // Validates a floor number (kMinFloor-kMaxFloor).
   [[nodiscard]] static std::expected<void, ElevatorError> validateFloor(
       int floor);
 
+  // Maps a valid floor to its FloorSet index.
+  [[nodiscard]] static constexpr int toIndex(int floor) noexcept {
+    return floor - kMinFloor;
+  }
+
+  // Hall calls added with the given direction.
+  [[nodiscard]] Requests& hallCalls(Direction direction) noexcept;
+  [[nodiscard]] const Requests& hallCalls(Direction direction) const noexcept;
+
+  // Every floor the car still has to visit.
+  [[nodiscard]] Requests pendingRequests() const noexcept {
+    return internal_requests_ | external_requests_ | up_calls_ | down_calls_;
+  }
+
+  // Removes the current floor from the requests without a direction.
+  void clearCurrentFloor() noexcept;
+
+  // True if the last move() served a request, given the state before it.
+  [[nodiscard]] bool servedSince(const BasicElevatorController& before)
+      const noexcept;
+
   // Updates direction based on pending requests.
   void updateDirection() noexcept;
+};
 
-  /// @return True if there are requests above current floor.
-  [[nodiscard]] bool hasRequestsAbove() const noexcept;
+/// Controller for the reference building with floors 1-9.
+using ElevatorController = BasicElevatorController<1, 9>;
 
-  /// @return True if there are requests below current floor.
-  [[nodiscard]] bool hasRequestsBelow() const noexcept;
-};
+/**
+ * @brief Generates a human-readable error message for ElevatorError.
+ * @param error The error type.
+ * @param floor The invalid floor (if applicable).
+ * @return Descriptive error string for ElevatorController's floor range.
+ */
+std::string make_error_message(ElevatorError error, int floor);
+
+template <int MinFloor, int MaxFloor, typename Policy>
+std::expected<void, ElevatorError>
+BasicElevatorController<MinFloor, MaxFloor, Policy>::validateFloor(int floor) {
+  // One unsigned compare covers both bounds.
+  if (static_cast<unsigned>(floor) - static_cast<unsigned>(kMinFloor) >=
+      static_cast<unsigned>(kFloorCount)) {
+    return std::unexpected(ElevatorError::InvalidFloor);
+  }
+  return {};
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+std::expected<void, ElevatorError>
+BasicElevatorController<MinFloor, MaxFloor, Policy>::addInternalRequest(
+    int floor) {
+  if (auto validation = validateFloor(floor); !validation) {
+    return validation;
+  }
+  internal_requests_.insert(toIndex(floor));
+  updateDirection();
+  return {};
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+std::expected<void, ElevatorError>
+BasicElevatorController<MinFloor, MaxFloor, Policy>::addExternalRequest(
+    int floor, Direction direction) {
+  if (auto validation = validateFloor(floor); !validation) {
+    return validation;
+  }
+  hallCalls(direction).insert(toIndex(floor));
+  updateDirection();
+  return {};
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+RequestBatchResult
+BasicElevatorController<MinFloor, MaxFloor, Policy>::addRequests(
+    std::span<const Request> requests) {
+  RequestBatchResult result;
+  for (size_t i = 0; i < requests.size(); ++i) {
+    const Request& request = requests[i];
+    if (!validateFloor(request.floor)) {
+      result.rejected.resize((requests.size() + 63) / 64);
+      result.rejected[i / 64] |= uint64_t{1} << (i % 64);
+      continue;
+    }
+    Requests& target = request.kind == Request::Kind::Internal
+                           ? internal_requests_
+                           : hallCalls(request.direction);
+    target.insert(toIndex(request.floor));
+    ++result.accepted;
+  }
+  if (result.accepted > 0) {
+    updateDirection();
+  }
+  return result;
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+void BasicElevatorController<MinFloor, MaxFloor, Policy>::move() {
+  if (direction_ == Direction::IDLE) {
+    return;
+  }
+
+  clearCurrentFloor();
+
+  if (direction_ == Direction::UP && current_floor_ < kMaxFloor) {
+    ++current_floor_;
+  } else if (direction_ == Direction::DOWN && current_floor_ > kMinFloor) {
+    --current_floor_;
+  }
+
+  updateDirection();
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+std::optional<int>
+BasicElevatorController<MinFloor, MaxFloor, Policy>::nextStop() const noexcept {
+  if constexpr (!std::same_as<Policy, LookPolicy>) {
+    // Other policies may turn anywhere, so follow move() on a copy; any
+    // policy reaches some request within two sweeps of the shaft.
+    BasicElevatorController probe = *this;
+    for (int i = 0; i < 2 * kFloorCount && probe.hasRequests(); ++i) {
+      const BasicElevatorController before = probe;
+      probe.move();
+      if (probe.servedSince(before)) {
+        return probe.current_floor_;
+      }
+    }
+    return std::nullopt;
+  }
+  // Floors on the way that move() always serves when reached; without one,
+  // the car runs to the farthest request and turns there.
+  const int index = toIndex(current_floor_);
+  std::optional<int> stop;
+  if (direction_ == Direction::UP) {
+    stop = (internal_requests_ | external_requests_ | up_calls_)
+               .nearestAbove(index);
+    stop = stop ? stop : pendingRequests().highest();
+  } else if (direction_ == Direction::DOWN) {
+    stop = (internal_requests_ | external_requests_ | down_calls_)
+               .nearestBelow(index);
+    stop = stop ? stop : pendingRequests().lowest();
+  }
+  return stop.transform([](int floor) { return floor + kMinFloor; });
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+int BasicElevatorController<MinFloor, MaxFloor, Policy>::advanceToNextStop()
+    noexcept {
+  if constexpr (!std::same_as<Policy, LookPolicy>) {
+    int travelled = 0;
+    while (travelled < 2 * kFloorCount && hasRequests()) {
+      const BasicElevatorController before = *this;
+      move();
+      ++travelled;
+      if (servedSince(before)) {
+        break;
+      }
+    }
+    return travelled;
+  }
+  const std::optional<int> stop = nextStop();
+  if (!stop) {
+    return 0;
+  }
+  // No floor in between changes the direction or clears a request.
+  const int travelled = *stop > current_floor_ ? *stop - current_floor_
+                                               : current_floor_ - *stop;
+  clearCurrentFloor();
+  current_floor_ = *stop;
+  updateDirection();
+  return travelled;
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+bool BasicElevatorController<MinFloor, MaxFloor, Policy>::hasRequests()
+    const noexcept {
+  return !pendingRequests().empty();
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+void BasicElevatorController<MinFloor, MaxFloor, Policy>::cancelExternalRequest(
+    int floor, Direction direction) noexcept {
+  if (!validateFloor(floor)) {
+    return;
+  }
+  hallCalls(direction).erase(toIndex(floor));
+  updateDirection();
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+bool BasicElevatorController<MinFloor, MaxFloor, Policy>::hasExternalRequest(
+    int floor, Direction direction) const noexcept {
+  return validateFloor(floor) && hallCalls(direction).contains(toIndex(floor));
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+int BasicElevatorController<MinFloor, MaxFloor, Policy>::pendingStopCount()
+    const noexcept {
+  return pendingRequests().count();
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+std::optional<int>
+BasicElevatorController<MinFloor, MaxFloor, Policy>::highestRequest()
+    const noexcept {
+  return pendingRequests().highest().transform(
+      [](int index) { return index + kMinFloor; });
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+std::optional<int>
+BasicElevatorController<MinFloor, MaxFloor, Policy>::lowestRequest()
+    const noexcept {
+  return pendingRequests().lowest().transform(
+      [](int index) { return index + kMinFloor; });
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+auto BasicElevatorController<MinFloor, MaxFloor, Policy>::hallCalls(
+    Direction direction) noexcept -> Requests& {
+  switch (direction) {
+    case Direction::UP:
+      return up_calls_;
+    case Direction::DOWN:
+      return down_calls_;
+    case Direction::IDLE:
+      break;
+  }
+  return external_requests_;
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+auto BasicElevatorController<MinFloor, MaxFloor, Policy>::hallCalls(
+    Direction direction) const noexcept -> const Requests& {
+  switch (direction) {
+    case Direction::UP:
+      return up_calls_;
+    case Direction::DOWN:
+      return down_calls_;
+    case Direction::IDLE:
+      break;
+  }
+  return external_requests_;
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+void BasicElevatorController<MinFloor, MaxFloor, Policy>::clearCurrentFloor()
+    noexcept {
+  internal_requests_.erase(toIndex(current_floor_));
+  external_requests_.erase(toIndex(current_floor_));
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+void BasicElevatorController<MinFloor, MaxFloor, Policy>::updateDirection()
+    noexcept {
+  clearCurrentFloor();
+
+  const Direction previous = direction_;
+  direction_ = Policy::nextDirection(previous, toIndex(current_floor_),
+                                     pendingRequests());
+
+  // Hall calls here are served when the car leaves in their direction, or
+  // turns around or parks here.
+  const bool both = direction_ != previous || direction_ == Direction::IDLE;
+  if (both || direction_ == Direction::UP) {
+    up_calls_.erase(toIndex(current_floor_));
+  }
+  if (both || direction_ == Direction::DOWN) {
+    down_calls_.erase(toIndex(current_floor_));
+  }
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+bool BasicElevatorController<MinFloor, MaxFloor, Policy>::servedSince(
+    const BasicElevatorController& before) const noexcept {
+  return internal_requests_ != before.internal_requests_ ||
+         external_requests_ != before.external_requests_ ||
+         up_calls_ != before.up_calls_ || down_calls_ != before.down_calls_;
+}
+
+// The reference building is compiled once, in elevator_controller.cpp.
+extern template class BasicElevatorController<1, 9>;
 
-}  // namespace elevator
\ No newline at end of file
+}  // namespace elevator
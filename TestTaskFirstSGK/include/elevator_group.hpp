@@ -0,0 +1,325 @@
+/**
+ * @file elevator_group.hpp
+ * @brief Implements a dispatcher for a bank of elevator cars.
+ */
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <expected>
+#include <optional>
+#include <vector>
+
+#include "direction.hpp"
+#include "elevator_controller.hpp"
+#include "floor_set.hpp"
+
+namespace elevator {
+
+/**
+ * @class BasicElevatorGroup
+ * @brief Owns a bank of cars and assigns every hall call to one of them.
+ * @tparam MinFloor Lowest floor of the building.
+ * @tparam MaxFloor Highest floor of the building.
+ *
+ * A hall call goes to the car with the lowest estimated time-to-serve,
+ * measured in floors travelled: the distance along the car's LOOK route to
+ * the call plus a penalty for every stop the car still has to make. A
+ * directional call is only counted as reached when the car arrives moving
+ * its way, so a car heading the other way is charged its return sweep. The
+ * state the estimate needs is mirrored in contiguous per-car arrays, so
+ * scoring all cars is one branch-free loop the compiler can vectorize.
+ *
+ * After every step() the pending hall calls are scored again and moved to
+ * another car when it has become clearly cheaper.
+ */
+template <int MinFloor, int MaxFloor>
+class BasicElevatorGroup {
+ public:
+  /// Controller type of every car.
+  using Car = BasicElevatorController<MinFloor, MaxFloor>;
+
+  /// Default cost of one pending stop, in floors of travel.
+  static constexpr int kDefaultStopPenalty = 2;
+  /// Cost advantage, in floors, another car needs to take over a hall call.
+  static constexpr int kReassignMargin = 2;
+
+  /**
+   * @brief Creates a group of idle cars on the lowest floor.
+   * @param car_count Number of cars, at least one.
+   * @param stop_penalty Cost of one pending stop, in floors of travel.
+   */
+  explicit BasicElevatorGroup(size_t car_count,
+                              int stop_penalty = kDefaultStopPenalty);
+
+  /**
+   * @brief Adds a hall call and assigns it to the cheapest car.
+   * @param floor Requested floor (Car::kMinFloor-Car::kMaxFloor).
+   * @param direction Button pressed: UP or DOWN, or IDLE for a call without
+   *        a direction.
+   * @return std::expected<size_t, ElevatorError>
+   *         - Success: index of the car serving the call.
+   *         - Failure: ElevatorError with details.
+   */
+  [[nodiscard]] std::expected<size_t, ElevatorError> addExternalRequest(
+      int floor, Direction direction = Direction::IDLE);
+
+  /**
+   * @brief Adds a request from inside one car (passenger input).
+   * @param car Index of the car, below size().
+   * @param floor Target floor (Car::kMinFloor-Car::kMaxFloor).
+   * @return std::expected<void, ElevatorError>
+   *         - Success: void
+   *         - Failure: InvalidCar for a car index past size(), otherwise
+   *           ElevatorError with details.
+   */
+  [[nodiscard]] std::expected<void, ElevatorError> addInternalRequest(
+      size_t car, int floor);
+
+  /**
+   * @brief Moves every car one floor and rebalances pending hall calls.
+   */
+  void step();
+
+  /// @return Car with the given index, below size().
+  [[nodiscard]] const Car& car(size_t index) const noexcept {
+    return cars_[index];
+  }
+
+  /// @return Number of cars.
+  [[nodiscard]] size_t size() const noexcept { return cars_.size(); }
+
+  /// @return True if any car has pending requests.
+  [[nodiscard]] bool hasRequests() const noexcept;
+
+  /// @return Car serving the hall call at the floor, if one is pending.
+  [[nodiscard]] std::optional<size_t> assignedCar(
+      int floor, Direction direction = Direction::IDLE) const noexcept;
+
+ private:
+  static constexpr int kFloorCount = Car::kFloorCount;
+  /// Kinds of hall call, indexed by Direction: UP, DOWN and undirected.
+  static constexpr size_t kCallKinds = 3;
+
+  std::vector<Car> cars_;  ///< The cars, indexed like the arrays below.
+  const int stop_penalty_;  ///< Cost of one pending stop.
+
+  // Per-car estimate inputs, refreshed whenever a car changes.
+  std::vector<int> floors_;      ///< Current floor.
+  std::vector<int> directions_;  ///< +1 up, -1 down, 0 idle.
+  std::vector<int> tops_;        ///< Highest stop, at least the floor.
+  std::vector<int> bottoms_;     ///< Lowest stop, at most the floor.
+  std::vector<int> stops_;       ///< Pending stop count.
+  std::vector<int> costs_;       ///< Scratch output of scoreCars().
+
+  /// Floors with a pending hall call, per kind of call.
+  std::array<FloorSet<kFloorCount>, kCallKinds> hall_calls_{};
+  std::vector<size_t> assignments_;  ///< Car of each pending hall call.
+
+  // Position of a hall call in assignments_.
+  [[nodiscard]] static size_t slot(int index, Direction direction) noexcept {
+    return static_cast<size_t>(direction) * kFloorCount +
+           static_cast<size_t>(index);
+  }
+
+  // Copies the estimate inputs of one car into the arrays.
+  void refresh(size_t car) noexcept;
+
+  // Fills costs_ with every car's time-to-serve for a call at the floor.
+  void scoreCars(int floor, Direction direction) noexcept;
+
+  // Index of the cheapest car in costs_.
+  [[nodiscard]] size_t cheapestCar() const noexcept;
+
+  // Drops served hall calls and hands the others to clearly cheaper cars.
+  void rebalance();
+};
+
+/// Group of cars for the reference building with floors 1-9.
+using ElevatorGroup = BasicElevatorGroup<1, 9>;
+
+template <int MinFloor, int MaxFloor>
+BasicElevatorGroup<MinFloor, MaxFloor>::BasicElevatorGroup(size_t car_count,
+                                                           int stop_penalty)
+    : cars_(std::max<size_t>(car_count, 1)),
+      stop_penalty_(stop_penalty),
+      floors_(cars_.size()),
+      directions_(cars_.size()),
+      tops_(cars_.size()),
+      bottoms_(cars_.size()),
+      stops_(cars_.size()),
+      costs_(cars_.size()),
+      assignments_(kCallKinds * kFloorCount) {
+  for (size_t i = 0; i < cars_.size(); ++i) {
+    refresh(i);
+  }
+}
+
+template <int MinFloor, int MaxFloor>
+std::expected<size_t, ElevatorError>
+BasicElevatorGroup<MinFloor, MaxFloor>::addExternalRequest(
+    int floor, Direction direction) {
+  if (auto pending = assignedCar(floor, direction)) {
+    return *pending;
+  }
+
+  scoreCars(floor, direction);
+  const size_t best = cheapestCar();
+  if (auto result = cars_[best].addExternalRequest(floor, direction);
+      !result) {
+    return std::unexpected(result.error());
+  }
+  refresh(best);
+
+  // A car at the floor may serve the call on the spot.
+  if (cars_[best].hasExternalRequest(floor, direction)) {
+    const int index = floor - Car::kMinFloor;
+    hall_calls_[static_cast<size_t>(direction)].insert(index);
+    assignments_[slot(index, direction)] = best;
+  }
+  return best;
+}
+
+template <int MinFloor, int MaxFloor>
+std::expected<void, ElevatorError>
+BasicElevatorGroup<MinFloor, MaxFloor>::addInternalRequest(size_t car,
+                                                           int floor) {
+  if (car >= cars_.size()) {
+    return std::unexpected(ElevatorError::InvalidCar);
+  }
+  auto result = cars_[car].addInternalRequest(floor);
+  refresh(car);
+  return result;
+}
+
+template <int MinFloor, int MaxFloor>
+void BasicElevatorGroup<MinFloor, MaxFloor>::step() {
+  for (size_t i = 0; i < cars_.size(); ++i) {
+    cars_[i].move();
+    refresh(i);
+  }
+  rebalance();
+}
+
+template <int MinFloor, int MaxFloor>
+bool BasicElevatorGroup<MinFloor, MaxFloor>::hasRequests() const noexcept {
+  return std::ranges::any_of(cars_,
+                             [](const Car& car) { return car.hasRequests(); });
+}
+
+template <int MinFloor, int MaxFloor>
+std::optional<size_t> BasicElevatorGroup<MinFloor, MaxFloor>::assignedCar(
+    int floor, Direction direction) const noexcept {
+  const int index = floor - Car::kMinFloor;
+  if (index < 0 || index >= kFloorCount ||
+      !hall_calls_[static_cast<size_t>(direction)].contains(index)) {
+    return std::nullopt;
+  }
+  return assignments_[slot(index, direction)];
+}
+
+template <int MinFloor, int MaxFloor>
+void BasicElevatorGroup<MinFloor, MaxFloor>::refresh(size_t car) noexcept {
+  const Car& state = cars_[car];
+  const int floor = state.getCurrentFloor();
+  floors_[car] = floor;
+  switch (state.getCurrentDirection()) {
+    case Direction::UP:
+      directions_[car] = 1;
+      break;
+    case Direction::DOWN:
+      directions_[car] = -1;
+      break;
+    case Direction::IDLE:
+      directions_[car] = 0;
+      break;
+  }
+  tops_[car] = std::max(floor, state.highestRequest().value_or(floor));
+  bottoms_[car] = std::min(floor, state.lowestRequest().value_or(floor));
+  stops_[car] = state.pendingStopCount();
+}
+
+template <int MinFloor, int MaxFloor>
+void BasicElevatorGroup<MinFloor, MaxFloor>::scoreCars(
+    int floor, Direction direction) noexcept {
+  // Every route is computed for every car and the right one selected, so
+  // the loop has no data-dependent branches or loads. A car sweeping past
+  // the call reaches it directly only if the call accepts that direction;
+  // otherwise it turns at its far end, and a call the other way round also
+  // needs the opposite end before it is reached in its own direction.
+  const bool accepts_up = direction != Direction::DOWN;
+  const bool accepts_down = direction != Direction::UP;
+  const bool up_only = direction == Direction::UP;
+  const bool down_only = direction == Direction::DOWN;
+  const int* floors = floors_.data();
+  const int* directions = directions_.data();
+  const int* tops = tops_.data();
+  const int* bottoms = bottoms_.data();
+  const int* stops = stops_.data();
+  int* costs = costs_.data();
+  const size_t count = cars_.size();
+  for (size_t i = 0; i < count; ++i) {
+    const int current = floors[i];
+    const int top = std::max(tops[i], floor);
+    const int bottom = std::min(bottoms[i], floor);
+    const int span = top - bottom;
+    const int up = floor >= current && accepts_up ? floor - current
+                   : up_only ? top - current + span + floor - bottom
+                             : top - current + top - floor;
+    const int down = floor <= current && accepts_down ? current - floor
+                     : down_only ? current - bottom + span + top - floor
+                                 : current - bottom + floor - bottom;
+    const int idle = std::abs(floor - current);
+    const int travel = directions[i] > 0   ? up
+                       : directions[i] < 0 ? down
+                                           : idle;
+    costs[i] = travel + stop_penalty_ * stops[i];
+  }
+}
+
+template <int MinFloor, int MaxFloor>
+size_t BasicElevatorGroup<MinFloor, MaxFloor>::cheapestCar() const noexcept {
+  return static_cast<size_t>(std::ranges::min_element(costs_) -
+                             costs_.begin());
+}
+
+template <int MinFloor, int MaxFloor>
+void BasicElevatorGroup<MinFloor, MaxFloor>::rebalance() {
+  for (size_t kind = 0; kind < kCallKinds; ++kind) {
+    const auto direction = static_cast<Direction>(kind);
+    FloorSet<kFloorCount>& calls = hall_calls_[kind];
+    for (auto index = calls.lowest(); index;
+         index = calls.nearestAbove(*index)) {
+      const int floor = *index + Car::kMinFloor;
+      size_t& owner = assignments_[slot(*index, direction)];
+      if (!cars_[owner].hasExternalRequest(floor, direction)) {
+        calls.erase(*index);
+        continue;
+      }
+
+      // The owner's cost includes this call's own stop, which biases the
+      // comparison towards keeping the assignment.
+      scoreCars(floor, direction);
+      const size_t best = cheapestCar();
+      if (best == owner || costs_[best] + kReassignMargin >= costs_[owner]) {
+        continue;
+      }
+      cars_[owner].cancelExternalRequest(floor, direction);
+      refresh(owner);
+      if (cars_[best].addExternalRequest(floor, direction)) {
+        refresh(best);
+        owner = best;
+      }
+      if (!cars_[owner].hasExternalRequest(floor, direction)) {
+        calls.erase(*index);  // Served on the spot.
+      }
+    }
+  }
+}
+
+// The reference building is compiled once, in elevator_group.cpp.
+extern template class BasicElevatorGroup<1, 9>;
+
+}  // namespace elevator
@@ -0,0 +1,292 @@
+/**
+ * @file elevator_simulator.hpp
+ * @brief Implements a discrete-event simulation of one elevator car.
+ */
+
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <queue>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "direction.hpp"
+#include "elevator_controller.hpp"
+
+namespace elevator {
+
+/// Simulated time.
+using Seconds = std::chrono::duration<double>;
+
+/**
+ * @struct Timing
+ * @brief Mechanical timings of a car.
+ *
+ * A run over n floors takes n * floor_travel + acceleration.
+ */
+struct Timing {
+  Seconds floor_travel{1.5};  ///< Time to pass one floor at full speed.
+  Seconds acceleration{2.0};  ///< Extra time to start and stop one run.
+  Seconds door_dwell{4.0};    ///< Time the doors stay open at a stop.
+};
+
+/**
+ * @struct Passenger
+ * @brief One journey of the traffic fed to the simulator.
+ */
+struct Passenger {
+  Seconds arrival{};  ///< Time the passenger presses the hall button.
+  int origin = 0;       ///< Floor the passenger waits on.
+  int destination = 0;  ///< Floor the passenger rides to.
+};
+
+/**
+ * @struct Trip
+ * @brief Outcome of one passenger's journey.
+ */
+struct Trip {
+  Seconds wait{};     ///< From arrival until the passenger boards.
+  Seconds journey{};  ///< From arrival until the passenger leaves the car.
+};
+
+/**
+ * @struct SimulationReport
+ * @brief Outcome of a simulation run.
+ */
+struct SimulationReport {
+  std::vector<Trip> trips;  ///< One per passenger, in input order.
+  Seconds end_time{};       ///< Time the last passenger left the car.
+  int stops = 0;            ///< Number of times the doors opened.
+  int floors_travelled = 0;  ///< Floors the car moved in total.
+};
+
+/**
+ * @class BasicElevatorSimulator
+ * @brief Drives a BasicElevatorController through a day of traffic.
+ * @tparam MinFloor Lowest floor of the building.
+ * @tparam MaxFloor Highest floor of the building.
+ * @tparam Policy SchedulingPolicy of the car.
+ *
+ * Time advances from event to event of a priority queue (passenger
+ * arrivals, car arrivals and door closings) rather than in fixed ticks.
+ * When the doors close, the controller jumps to its next stop and the
+ * arrival is scheduled after the whole run's travel time, so the cost of a
+ * simulation grows with the number of stops, not with its length in
+ * simulated time.
+ *
+ * Passengers press the hall button for their direction and press their
+ * destination once aboard. A run, once started, is not cut short: calls
+ * made during it are served from the stop the car is heading for.
+ */
+template <int MinFloor, int MaxFloor, typename Policy = LookPolicy>
+class BasicElevatorSimulator {
+ public:
+  /// Controller type of the car.
+  using Car = BasicElevatorController<MinFloor, MaxFloor, Policy>;
+
+  /**
+   * @brief Creates a simulator for a car with the given timings.
+   * @param timing Mechanical timings of the car.
+   */
+  explicit BasicElevatorSimulator(const Timing& timing = {}) noexcept
+      : timing_(timing) {}
+
+  /**
+   * @brief Simulates the car, starting idle on the lowest floor, until every
+   * passenger has arrived at their destination.
+   * @param passengers Traffic to serve, in any order.
+   * @return std::expected<SimulationReport, ElevatorError>
+   *         - Success: the trips of all passengers.
+   *         - Failure: ElevatorError if a passenger uses an invalid floor.
+   */
+  [[nodiscard]] std::expected<SimulationReport, ElevatorError> run(
+      std::span<const Passenger> passengers);
+
+ private:
+  static constexpr int kFloorCount = Car::kFloorCount;
+
+  enum class EventKind : uint8_t { PassengerArrival, CarArrival, DoorsClosed };
+
+  struct Event {
+    Seconds time;
+    uint64_t sequence;  ///< Breaks ties in scheduling order.
+    EventKind kind;
+    size_t passenger;  ///< Arriving passenger, for PassengerArrival.
+
+    bool operator>(const Event& other) const noexcept {
+      return time != other.time ? time > other.time
+                                : sequence > other.sequence;
+    }
+  };
+
+  enum class CarState : uint8_t { Idle, Moving, DoorsOpen };
+
+  const Timing timing_;  ///< Mechanical timings of the car.
+
+  // State of the current run().
+  Car car_;
+  CarState state_{CarState::Idle};
+  std::priority_queue<Event, std::vector<Event>, std::greater<>> events_;
+  uint64_t sequence_ = 0;
+  std::span<const Passenger> passengers_;
+  std::vector<std::vector<size_t>> waiting_;  ///< Passengers per floor.
+  std::vector<size_t> riders_;                ///< Passengers in the car.
+  SimulationReport report_;
+
+  void schedule(Seconds time, EventKind kind, size_t passenger = 0);
+
+  // Handles a passenger pressing the hall button.
+  void onPassengerArrival(Seconds now, size_t passenger);
+
+  // Opens the doors at the current floor, exchanging passengers.
+  void openDoors(Seconds now);
+
+  // Lets waiting passengers on whose call the car stopped board it.
+  void board(Seconds now);
+
+  // Starts the run to the next stop, or parks the car.
+  void depart(Seconds now);
+
+  [[nodiscard]] static Direction directionOf(const Passenger& passenger) {
+    return passenger.destination > passenger.origin ? Direction::UP
+                                                    : Direction::DOWN;
+  }
+};
+
+/// Simulator for the reference building with floors 1-9.
+using ElevatorSimulator = BasicElevatorSimulator<1, 9>;
+
+template <int MinFloor, int MaxFloor, typename Policy>
+std::expected<SimulationReport, ElevatorError>
+BasicElevatorSimulator<MinFloor, MaxFloor, Policy>::run(
+    std::span<const Passenger> passengers) {
+  for (const Passenger& passenger : passengers) {
+    for (const int floor : {passenger.origin, passenger.destination}) {
+      if (floor < Car::kMinFloor || floor > Car::kMaxFloor) {
+        return std::unexpected(ElevatorError::InvalidFloor);
+      }
+    }
+  }
+
+  car_ = Car{};
+  state_ = CarState::Idle;
+  events_ = {};
+  sequence_ = 0;
+  passengers_ = passengers;
+  waiting_.assign(kFloorCount, {});
+  riders_.clear();
+  report_ = SimulationReport{};
+  report_.trips.resize(passengers.size());
+
+  for (size_t i = 0; i < passengers.size(); ++i) {
+    schedule(passengers[i].arrival, EventKind::PassengerArrival, i);
+  }
+  while (!events_.empty()) {
+    const Event event = events_.top();
+    events_.pop();
+    switch (event.kind) {
+      case EventKind::PassengerArrival:
+        onPassengerArrival(event.time, event.passenger);
+        break;
+      case EventKind::CarArrival:
+        openDoors(event.time);
+        break;
+      case EventKind::DoorsClosed:
+        depart(event.time);
+        break;
+    }
+  }
+  return std::move(report_);
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+void BasicElevatorSimulator<MinFloor, MaxFloor, Policy>::schedule(
+    Seconds time, EventKind kind, size_t passenger) {
+  events_.push(Event{time, sequence_++, kind, passenger});
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+void BasicElevatorSimulator<MinFloor, MaxFloor, Policy>::onPassengerArrival(
+    Seconds now, size_t passenger) {
+  const Passenger& person = passengers_[passenger];
+  if (person.origin == person.destination) {
+    report_.end_time = std::max(report_.end_time, now);
+    return;  // Nothing to ride; the trip stays zero.
+  }
+
+  waiting_[static_cast<size_t>(person.origin - Car::kMinFloor)].push_back(
+      passenger);
+  // The floor was validated by run().
+  (void)car_.addExternalRequest(person.origin, directionOf(person));
+
+  if (state_ == CarState::DoorsOpen) {
+    if (car_.getCurrentFloor() == person.origin) {
+      board(now);
+    }
+  } else if (state_ == CarState::Idle) {
+    if (car_.hasRequests()) {
+      depart(now);
+    } else {
+      openDoors(now);  // Served where the car is parked.
+    }
+  }
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+void BasicElevatorSimulator<MinFloor, MaxFloor, Policy>::openDoors(
+    Seconds now) {
+  state_ = CarState::DoorsOpen;
+  ++report_.stops;
+
+  const int floor = car_.getCurrentFloor();
+  std::erase_if(riders_, [&](size_t rider) {
+    if (passengers_[rider].destination != floor) {
+      return false;
+    }
+    report_.trips[rider].journey = now - passengers_[rider].arrival;
+    report_.end_time = std::max(report_.end_time, now);
+    return true;
+  });
+  board(now);
+  schedule(now + timing_.door_dwell, EventKind::DoorsClosed);
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+void BasicElevatorSimulator<MinFloor, MaxFloor, Policy>::board(Seconds now) {
+  const int floor = car_.getCurrentFloor();
+  std::erase_if(
+      waiting_[static_cast<size_t>(floor - Car::kMinFloor)], [&](size_t p) {
+        const Passenger& person = passengers_[p];
+        if (car_.hasExternalRequest(floor, directionOf(person))) {
+          return false;  // The car leaves the other way.
+        }
+        report_.trips[p].wait = now - person.arrival;
+        riders_.push_back(p);
+        (void)car_.addInternalRequest(person.destination);
+        return true;
+      });
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+void BasicElevatorSimulator<MinFloor, MaxFloor, Policy>::depart(Seconds now) {
+  if (!car_.hasRequests()) {
+    state_ = CarState::Idle;
+    return;
+  }
+
+  const int floors = car_.advanceToNextStop();
+  state_ = CarState::Moving;
+  report_.floors_travelled += floors;
+  schedule(now + floors * timing_.floor_travel + timing_.acceleration,
+           EventKind::CarArrival);
+}
+
+// The reference building is compiled once, in elevator_simulator.cpp.
+extern template class BasicElevatorSimulator<1, 9>;
+
+}  // namespace elevator
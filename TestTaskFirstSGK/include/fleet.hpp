@@ -0,0 +1,250 @@
+/**
+ * @file fleet.hpp
+ * @brief Implements structure-of-arrays storage for many independent cars.
+ */
+
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <expected>
+#include <vector>
+
+#include "direction.hpp"
+#include "elevator_controller.hpp"
+#include "floor_set.hpp"
+
+namespace elevator {
+
+/**
+ * @class BasicFleet
+ * @brief Many independent cars with ElevatorController semantics.
+ * @tparam MinFloor Lowest floor of the building.
+ * @tparam MaxFloor Highest floor of the building.
+ *
+ * Cars are stored in blocks of kLanes. Within a block each field has its
+ * own contiguous array: positions, directions and the four request masks,
+ * one FloorSet word per car. The position is the car's floor as a single
+ * set bit, so moving is a shift. Adding requests and stepping leave every
+ * car exactly as a BasicElevatorController given the same calls would be;
+ * stepAll() applies move() lane by lane in a branch-free loop the compiler
+ * vectorizes. Unused lanes of the last block hold parked cars without
+ * requests, which move() leaves alone.
+ *
+ * @note The fleet is LOOK-only: stepAll() hard-codes LookPolicy and takes
+ *       no Policy parameter, so cars follow the default Car policy only.
+ */
+template <int MinFloor, int MaxFloor>
+class BasicFleet {
+  static_assert(MaxFloor - MinFloor < 64,
+                "A fleet keeps one mask word of at most 64 floors per car");
+
+ public:
+  /// Controller whose behaviour every car follows.
+  using Car = BasicElevatorController<MinFloor, MaxFloor>;
+
+  /**
+   * @brief Creates idle cars on the lowest floor.
+   * @param car_count Number of cars.
+   */
+  explicit BasicFleet(size_t car_count);
+
+  /// @return Number of cars.
+  [[nodiscard]] size_t size() const noexcept { return size_; }
+
+  /**
+   * @brief Adds a request from inside one car, see Car::addInternalRequest().
+   * @param car Index of the car, below size().
+   * @param floor Target floor (Car::kMinFloor-Car::kMaxFloor).
+   * @return std::expected<void, ElevatorError>
+   *         - Success: void
+   *         - Failure: ElevatorError with details.
+   */
+  [[nodiscard]] std::expected<void, ElevatorError> addInternalRequest(
+      size_t car, int floor);
+
+  /**
+   * @brief Adds a hall call to one car, see Car::addExternalRequest().
+   * @param car Index of the car, below size().
+   * @param floor Requested floor (Car::kMinFloor-Car::kMaxFloor).
+   * @param direction Button pressed, or IDLE for a call without direction.
+   * @return std::expected<void, ElevatorError>
+   *         - Success: void
+   *         - Failure: ElevatorError with details.
+   */
+  [[nodiscard]] std::expected<void, ElevatorError> addExternalRequest(
+      size_t car, int floor, Direction direction = Direction::IDLE);
+
+  /**
+   * @brief Moves every car as Car::move() would.
+   */
+  void stepAll() noexcept;
+
+  /// @return Current floor of a car.
+  [[nodiscard]] int getCurrentFloor(size_t car) const noexcept {
+    return std::countr_zero(blocks_[car / kLanes].positions[car % kLanes]) +
+           Car::kMinFloor;
+  }
+
+  /// @return Current direction of a car.
+  [[nodiscard]] Direction getCurrentDirection(size_t car) const noexcept {
+    return blocks_[car / kLanes].directions[car % kLanes];
+  }
+
+  /// @return True if a car has pending requests.
+  [[nodiscard]] bool hasRequests(size_t car) const noexcept {
+    const Block& block = blocks_[car / kLanes];
+    const size_t lane = car % kLanes;
+    return (block.internal[lane] | block.external[lane] |
+            block.up_calls[lane] | block.down_calls[lane]) != 0;
+  }
+
+ private:
+  using Word = typename FloorSet<Car::kFloorCount>::Word;
+
+  /// Position bit of the highest floor.
+  static constexpr Word kTopFloor = Word{1} << (Car::kFloorCount - 1);
+  /// Cars per block.
+  static constexpr size_t kLanes = 16;
+
+  // Fields of kLanes consecutive cars.
+  struct Block {
+    std::array<Word, kLanes> positions;  ///< Floor bit of each car.
+    std::array<Direction, kLanes> directions;  ///< Direction of each car.
+    std::array<Word, kLanes> internal;   ///< Passenger-selected floors.
+    std::array<Word, kLanes> external;   ///< Hall calls without direction.
+    std::array<Word, kLanes> up_calls;   ///< Hall calls going up.
+    std::array<Word, kLanes> down_calls;  ///< Hall calls going down.
+  };
+
+  size_t size_;                ///< Number of cars.
+  std::vector<Block> blocks_;  ///< The cars, kLanes per block.
+
+  // Car::updateDirection() of one car of a block.
+  static void updateDirection(Block& block, size_t lane) noexcept;
+
+  // Car::move() of one car of a block.
+  static void move(Block& block, size_t lane) noexcept;
+};
+
+/// Fleet of cars for the reference building with floors 1-9.
+using Fleet = BasicFleet<1, 9>;
+
+template <int MinFloor, int MaxFloor>
+BasicFleet<MinFloor, MaxFloor>::BasicFleet(size_t car_count)
+    : size_(car_count) {
+  Block parked{};
+  parked.positions.fill(Word{1});
+  parked.directions.fill(Direction::IDLE);
+  blocks_.assign((car_count + kLanes - 1) / kLanes, parked);
+}
+
+template <int MinFloor, int MaxFloor>
+std::expected<void, ElevatorError>
+BasicFleet<MinFloor, MaxFloor>::addInternalRequest(size_t car, int floor) {
+  if (floor < Car::kMinFloor || floor > Car::kMaxFloor) {
+    return std::unexpected(ElevatorError::InvalidFloor);
+  }
+  Block& block = blocks_[car / kLanes];
+  const size_t lane = car % kLanes;
+  block.internal[lane] |=
+      static_cast<Word>(Word{1} << (floor - Car::kMinFloor));
+  updateDirection(block, lane);
+  return {};
+}
+
+template <int MinFloor, int MaxFloor>
+std::expected<void, ElevatorError>
+BasicFleet<MinFloor, MaxFloor>::addExternalRequest(size_t car, int floor,
+                                                   Direction direction) {
+  if (floor < Car::kMinFloor || floor > Car::kMaxFloor) {
+    return std::unexpected(ElevatorError::InvalidFloor);
+  }
+  Block& block = blocks_[car / kLanes];
+  const size_t lane = car % kLanes;
+  const auto bit = static_cast<Word>(Word{1} << (floor - Car::kMinFloor));
+  switch (direction) {
+    case Direction::UP:
+      block.up_calls[lane] |= bit;
+      break;
+    case Direction::DOWN:
+      block.down_calls[lane] |= bit;
+      break;
+    case Direction::IDLE:
+      block.external[lane] |= bit;
+      break;
+  }
+  updateDirection(block, lane);
+  return {};
+}
+
+template <int MinFloor, int MaxFloor>
+void BasicFleet<MinFloor, MaxFloor>::stepAll() noexcept {
+  for (Block& block : blocks_) {
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      move(block, lane);
+    }
+  }
+}
+
+template <int MinFloor, int MaxFloor>
+void BasicFleet<MinFloor, MaxFloor>::updateDirection(Block& block,
+                                                     size_t lane) noexcept {
+  // Car::updateDirection() in bitwise logic and selects, without branches
+  // or short-circuits, so the lane loop vectorizes.
+  static_assert(static_cast<int>(Direction::UP) == 0 &&
+                    static_cast<int>(Direction::DOWN) == 1 &&
+                    static_cast<int>(Direction::IDLE) == 2,
+                "The direction is computed from its numeric value");
+  const Word bit = block.positions[lane];
+  const auto keep = static_cast<Word>(~bit);
+  const auto below_mask = static_cast<Word>(bit - 1);
+  const auto above_mask = static_cast<Word>(~(below_mask | bit));
+  const auto internal = static_cast<Word>(block.internal[lane] & keep);
+  const auto external = static_cast<Word>(block.external[lane] & keep);
+  const Word up_calls = block.up_calls[lane];
+  const Word down_calls = block.down_calls[lane];
+
+  const Direction previous = block.directions[lane];
+  const auto pending =
+      static_cast<Word>(internal | external | up_calls | down_calls);
+  const bool above = (pending & above_mask) != 0;
+  const bool below = (pending & below_mask) != 0;
+  // A car going down keeps going down; any other prefers up.
+  const bool go_down = below & ((previous == Direction::DOWN) | !above);
+  const bool go_up = above & !go_down;
+  const auto direction = static_cast<Direction>(2 - 2 * go_up - go_down);
+
+  const bool both = (direction != previous) | (direction == Direction::IDLE);
+  const bool clear_up = both | (direction == Direction::UP);
+  const bool clear_down = both | (direction == Direction::DOWN);
+  block.directions[lane] = direction;
+  block.internal[lane] = internal;
+  block.external[lane] = external;
+  block.up_calls[lane] =
+      static_cast<Word>(up_calls & ~(clear_up ? bit : Word{0}));
+  block.down_calls[lane] =
+      static_cast<Word>(down_calls & ~(clear_down ? bit : Word{0}));
+}
+
+template <int MinFloor, int MaxFloor>
+void BasicFleet<MinFloor, MaxFloor>::move(Block& block, size_t lane) noexcept {
+  // An idle car needs no special case: it has no requests, so clearing its
+  // floor and updating its direction change nothing.
+  const Word bit = block.positions[lane];
+  const Direction direction = block.directions[lane];
+  const bool up = (direction == Direction::UP) & (bit < kTopFloor);
+  const bool down = (direction == Direction::DOWN) & (bit > 1);
+  const auto higher = static_cast<Word>(bit << 1);
+  const auto lower = static_cast<Word>(bit >> 1);
+  block.positions[lane] = up ? higher : down ? lower : bit;
+  // Clears the departure floor as move() does.
+  block.internal[lane] &= static_cast<Word>(~bit);
+  block.external[lane] &= static_cast<Word>(~bit);
+  updateDirection(block, lane);
+}
+
+// The reference building is compiled once, in fleet.cpp.
+extern template class BasicFleet<1, 9>;
+
+}  // namespace elevator
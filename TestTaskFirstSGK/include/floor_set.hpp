@@ -0,0 +1,169 @@
+/**
+ * @file floor_set.hpp
+ * @brief Defines a compact bitmask-based set of floors.
+ */
+
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <type_traits>
+
+namespace elevator {
+
+/**
+ * @class FloorSet
+ * @brief Set of floors stored as one bit per floor.
+ * @tparam kFloors Number of floors in the building.
+ *
+ * Floors are addressed by their index above the lowest floor, so bit 0 is
+ * the lowest floor. The storage is the narrowest unsigned word that holds
+ * every floor (a single uint16_t, uint32_t or uint64_t), or an array of
+ * uint64_t words for taller buildings. Membership, above/below queries and
+ * the nearest member in either direction are a few bit operations per word.
+ */
+template <int kFloors>
+class FloorSet {
+  static_assert(kFloors > 0, "A building needs at least one floor");
+
+ public:
+  /// Storage word, one bit per floor.
+  using Word = std::conditional_t<
+      kFloors <= 16, uint16_t,
+      std::conditional_t<kFloors <= 32, uint32_t, uint64_t>>;
+
+  /// Number of floors a set can hold.
+  static constexpr int kCapacity = kFloors;
+
+  constexpr FloorSet() noexcept = default;
+
+  /// @brief Adds the floor with the given index (0 to kCapacity - 1).
+  constexpr void insert(int index) noexcept {
+    words_[wordOf(index)] |= bit(index);
+  }
+
+  /// @brief Removes the floor with the given index, if present.
+  constexpr void erase(int index) noexcept {
+    words_[wordOf(index)] &= static_cast<Word>(~bit(index));
+  }
+
+  /// @return True if the floor with the given index is in the set.
+  [[nodiscard]] constexpr bool contains(int index) const noexcept {
+    return (words_[wordOf(index)] & bit(index)) != 0;
+  }
+
+  /// @return True if the set has no floors.
+  [[nodiscard]] constexpr bool empty() const noexcept {
+    for (const Word word : words_) {
+      if (word != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// @return Number of floors in the set.
+  [[nodiscard]] constexpr int count() const noexcept {
+    int total = 0;
+    for (const Word word : words_) {
+      total += std::popcount(word);
+    }
+    return total;
+  }
+
+  /// @return Index of the lowest floor in the set, if any.
+  [[nodiscard]] constexpr std::optional<int> lowest() const noexcept {
+    return contains(0) ? std::optional<int>(0) : nearestAbove(0);
+  }
+
+  /// @return Index of the highest floor in the set, if any.
+  [[nodiscard]] constexpr std::optional<int> highest() const noexcept {
+    return contains(kCapacity - 1) ? std::optional<int>(kCapacity - 1)
+                                   : nearestBelow(kCapacity - 1);
+  }
+
+  /// @return True if the set has a floor above the given index.
+  [[nodiscard]] constexpr bool anyAbove(int index) const noexcept {
+    return nearestAbove(index).has_value();
+  }
+
+  /// @return True if the set has a floor below the given index.
+  [[nodiscard]] constexpr bool anyBelow(int index) const noexcept {
+    return nearestBelow(index).has_value();
+  }
+
+  /// @return Index of the closest floor above the given index, if any.
+  [[nodiscard]] constexpr std::optional<int> nearestAbove(
+      int index) const noexcept {
+    size_t word = wordOf(index);
+    Word bits = words_[word] & aboveMask(index);
+    while (bits == 0) {
+      if (++word == kWords) {
+        return std::nullopt;
+      }
+      bits = words_[word];
+    }
+    return static_cast<int>(word) * kWordBits + std::countr_zero(bits);
+  }
+
+  /// @return Index of the closest floor below the given index, if any.
+  [[nodiscard]] constexpr std::optional<int> nearestBelow(
+      int index) const noexcept {
+    size_t word = wordOf(index);
+    Word bits = words_[word] & belowMask(index);
+    while (bits == 0) {
+      if (word == 0) {
+        return std::nullopt;
+      }
+      bits = words_[--word];
+    }
+    return static_cast<int>(word) * kWordBits + kWordBits - 1 -
+           std::countl_zero(bits);
+  }
+
+  /// @return Set holding the floors of both sets.
+  [[nodiscard]] constexpr FloorSet operator|(
+      const FloorSet& other) const noexcept {
+    FloorSet result;
+    for (size_t i = 0; i < kWords; ++i) {
+      result.words_[i] = words_[i] | other.words_[i];
+    }
+    return result;
+  }
+
+  constexpr bool operator==(const FloorSet&) const noexcept = default;
+
+  /// @return Storage word w; bit i is the floor with index w * bits + i.
+  [[nodiscard]] constexpr Word word(size_t w) const noexcept {
+    return words_[w];
+  }
+
+ private:
+  static constexpr int kWordBits = std::numeric_limits<Word>::digits;
+  static constexpr size_t kWords = (kFloors + kWordBits - 1) / kWordBits;
+
+  std::array<Word, kWords> words_{};  ///< Bit i of word w is floor w*bits+i.
+
+  [[nodiscard]] static constexpr size_t wordOf(int index) noexcept {
+    return static_cast<size_t>(index / kWordBits);
+  }
+
+  [[nodiscard]] static constexpr Word bit(int index) noexcept {
+    return static_cast<Word>(Word{1} << (index % kWordBits));
+  }
+
+  // Bits of the index's word strictly below it.
+  [[nodiscard]] static constexpr Word belowMask(int index) noexcept {
+    return static_cast<Word>(bit(index) - 1);
+  }
+
+  // Bits of the index's word strictly above it.
+  [[nodiscard]] static constexpr Word aboveMask(int index) noexcept {
+    return static_cast<Word>(~(belowMask(index) | bit(index)));
+  }
+};
+
+}  // namespace elevator
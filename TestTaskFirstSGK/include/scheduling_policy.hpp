@@ -0,0 +1,107 @@
+/**
+ * @file scheduling_policy.hpp
+ * @brief Defines the strategies that choose a car's direction.
+ */
+
+#pragma once
+#include <concepts>
+
+#include "direction.hpp"
+#include "floor_set.hpp"
+
+namespace elevator {
+
+/**
+ * @brief A strategy for BasicElevatorController::updateDirection().
+ *
+ * P::nextDirection(previous, index, pending) returns the direction a car
+ * heading in previous should take at the floor with the given index, where
+ * pending holds every floor it still has to visit. The controller has
+ * already cleared the requests it serves at that floor; hall calls there
+ * are cleared afterwards according to the chosen direction. IDLE must be
+ * returned when no floor other than the current one is pending.
+ */
+template <typename P, int kFloors>
+concept SchedulingPolicy =
+    requires(Direction previous, int index, const FloorSet<kFloors>& pending) {
+      { P::nextDirection(previous, index, pending) } noexcept
+          -> std::same_as<Direction>;
+    };
+
+/**
+ * @struct LookPolicy
+ * @brief Keeps the direction while requests lie ahead, then reverses.
+ */
+struct LookPolicy {
+  template <int kFloors>
+  [[nodiscard]] static constexpr Direction nextDirection(
+      Direction previous, int index,
+      const FloorSet<kFloors>& pending) noexcept {
+    const bool above = pending.anyAbove(index);
+    const bool below = pending.anyBelow(index);
+    if (previous == Direction::DOWN) {
+      return below   ? Direction::DOWN
+             : above ? Direction::UP
+                     : Direction::IDLE;
+    }
+    // UP or IDLE
+    return above   ? Direction::UP
+           : below ? Direction::DOWN
+                   : Direction::IDLE;
+  }
+};
+
+/**
+ * @struct ScanPolicy
+ * @brief Sweeps to the end of the shaft before reversing.
+ */
+struct ScanPolicy {
+  template <int kFloors>
+  [[nodiscard]] static constexpr Direction nextDirection(
+      Direction previous, int index,
+      const FloorSet<kFloors>& pending) noexcept {
+    const bool above = pending.anyAbove(index);
+    const bool below = pending.anyBelow(index);
+    if (!above && !below) {
+      return Direction::IDLE;
+    }
+    switch (previous) {
+      case Direction::UP:
+        return index < kFloors - 1 ? Direction::UP : Direction::DOWN;
+      case Direction::DOWN:
+        return index > 0 ? Direction::DOWN : Direction::UP;
+      case Direction::IDLE:
+        break;
+    }
+    return above ? Direction::UP : Direction::DOWN;
+  }
+};
+
+/**
+ * @struct NearestRequestPolicy
+ * @brief Heads for the closest pending floor, keeping the direction on ties.
+ * @note Shortest travel per stop, but a stream of nearby requests can
+ *       starve distant ones.
+ */
+struct NearestRequestPolicy {
+  template <int kFloors>
+  [[nodiscard]] static constexpr Direction nextDirection(
+      Direction previous, int index,
+      const FloorSet<kFloors>& pending) noexcept {
+    const auto above = pending.nearestAbove(index);
+    const auto below = pending.nearestBelow(index);
+    if (!above || !below) {
+      return above   ? Direction::UP
+             : below ? Direction::DOWN
+                     : Direction::IDLE;
+    }
+    const int up = *above - index;
+    const int down = index - *below;
+    if (up != down) {
+      return up < down ? Direction::UP : Direction::DOWN;
+    }
+    return previous == Direction::DOWN ? Direction::DOWN : Direction::UP;
+  }
+};
+
+}  // namespace elevator
@@ -0,0 +1,176 @@
+/**
+ * @file telemetry.hpp
+ * @brief Implements batched state records of many cars for a byte stream.
+ */
+
+#pragma once
+#include <array>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "direction.hpp"
+#include "elevator_controller.hpp"
+
+namespace elevator {
+
+/**
+ * @struct TelemetryRecord
+ * @brief State of one car at one point in time.
+ *
+ * Records are written to the stream as they are laid out in memory (host
+ * byte order, no padding), sizeof(TelemetryRecord) bytes each.
+ */
+struct TelemetryRecord {
+  int64_t time = 0;      ///< Timestamp in nanoseconds.
+  uint64_t pending = 0;  ///< Bit i set if the floor with index i is pending.
+  uint32_t car = 0;      ///< Index of the car.
+  int32_t floor = 0;     ///< Current floor.
+  Direction direction = Direction::IDLE;  ///< Current direction.
+  std::array<uint8_t, 7> reserved{};      ///< Always zero.
+};
+
+static_assert(sizeof(TelemetryRecord) == 32 &&
+                  std::is_trivially_copyable_v<TelemetryRecord>,
+              "Records are copied to the stream byte for byte");
+
+/**
+ * @brief A byte stream written in place, like ByteStreamController of the
+ * second project.
+ *
+ * reserve(bytes) returns a writable span of exactly bytes, or an empty
+ * span if the stream refuses them; commit(bytes) publishes the span.
+ */
+template <typename S>
+concept ReservableStream = requires(S& stream, size_t bytes) {
+  { stream.reserve(bytes) } -> std::convertible_to<std::span<std::byte>>;
+  stream.commit(bytes);
+};
+
+/**
+ * @class TelemetrySink
+ * @brief Stages state records per car and writes them to a stream a block
+ * at a time.
+ * @tparam Stream ReservableStream receiving the records.
+ *
+ * Every car has its own staging block of kBlockRecords records. A full
+ * block goes to the stream with a single reserve() and commit(), so a
+ * stream behind a mutex is locked once per block rather than once per
+ * record, and each block holds consecutive records of one car. A sink is
+ * used by one thread; staged records are only written by flush(),
+ * flushAll() or a full block.
+ */
+template <ReservableStream Stream>
+class TelemetrySink {
+ public:
+  /// Records per staging block (2 KiB).
+  static constexpr size_t kBlockRecords = 64;
+
+  /**
+   * @brief Creates empty staging blocks.
+   * @param stream Stream receiving the blocks; must outlive the sink.
+   * @param car_count Number of cars.
+   */
+  TelemetrySink(Stream& stream, size_t car_count)
+      : stream_(stream), blocks_(car_count) {}
+
+  /// @return Number of cars.
+  [[nodiscard]] size_t size() const noexcept { return blocks_.size(); }
+
+  /**
+   * @brief Stages the state of a car, writing its block once full.
+   * @param car Index of the car, below size().
+   * @param time Timestamp of the record.
+   * @param controller Controller of the car.
+   */
+  template <int MinFloor, int MaxFloor, typename Policy>
+  void record(
+      size_t car, std::chrono::nanoseconds time,
+      const BasicElevatorController<MinFloor, MaxFloor, Policy>& controller);
+
+  /**
+   * @brief Writes the staged records of one car.
+   * @param car Index of the car, below size().
+   * @return False if the stream refused them; they count as dropped.
+   */
+  bool flush(size_t car);
+
+  /**
+   * @brief Writes the staged records of every car.
+   * @return False if the stream refused any of them.
+   */
+  bool flushAll();
+
+  /// @return Records the stream refused.
+  [[nodiscard]] size_t droppedRecords() const noexcept {
+    return dropped_records_;
+  }
+
+ private:
+  // Records of one car not written yet.
+  struct Block {
+    std::array<TelemetryRecord, kBlockRecords> records;
+    size_t count = 0;
+  };
+
+  Stream& stream_;            ///< Destination of full blocks.
+  std::vector<Block> blocks_;  ///< Staging block of each car.
+  size_t dropped_records_ = 0;  ///< Records the stream refused.
+};
+
+template <ReservableStream Stream>
+template <int MinFloor, int MaxFloor, typename Policy>
+void TelemetrySink<Stream>::record(
+    size_t car, std::chrono::nanoseconds time,
+    const BasicElevatorController<MinFloor, MaxFloor, Policy>& controller) {
+  static_assert(MaxFloor - MinFloor < 64,
+                "A record holds a pending mask of at most 64 floors");
+  Block& block = blocks_[car];
+  TelemetryRecord& entry = block.records[block.count];
+  entry.time = time.count();
+  entry.pending = controller.pendingFloors().word(0);
+  entry.car = static_cast<uint32_t>(car);
+  entry.floor = controller.getCurrentFloor();
+  entry.direction = controller.getCurrentDirection();
+  if (++block.count == kBlockRecords) {
+    (void)flush(car);
+  }
+}
+
+template <ReservableStream Stream>
+bool TelemetrySink<Stream>::flush(size_t car) {
+  Block& block = blocks_[car];
+  if (block.count == 0) {
+    return true;
+  }
+  const size_t bytes = block.count * sizeof(TelemetryRecord);
+  const std::span<std::byte> target = stream_.reserve(bytes);
+  const bool written = target.size() == bytes;
+  if (written) {
+    std::memcpy(target.data(), block.records.data(), bytes);
+    stream_.commit(bytes);
+  } else {
+    if (!target.empty()) {
+      stream_.commit(0);  // Abandons a reservation of the wrong size.
+    }
+    dropped_records_ += block.count;
+  }
+  block.count = 0;
+  return written;
+}
+
+template <ReservableStream Stream>
+bool TelemetrySink<Stream>::flushAll() {
+  bool written = true;
+  for (size_t car = 0; car < blocks_.size(); ++car) {
+    written = flush(car) && written;
+  }
+  return written;
+}
+
+}  // namespace elevator
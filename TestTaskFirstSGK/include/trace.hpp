@@ -0,0 +1,230 @@
+/**
+ * @file trace.hpp
+ * @brief Implements recording and replay of controller calls.
+ */
+
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <span>
+#include <system_error>
+#include <vector>
+
+#include "direction.hpp"
+#include "elevator_controller.hpp"
+#include "fleet.hpp"
+
+namespace elevator {
+
+/**
+ * @struct TraceEvent
+ * @brief One recorded call.
+ */
+struct TraceEvent {
+  /// Recorded call.
+  enum class Kind : uint8_t {
+    InternalRequest,  ///< addInternalRequest(floor)
+    ExternalRequest,  ///< addExternalRequest(floor, direction)
+    Step              ///< move(), or stepAll() of a fleet
+  };
+
+  std::chrono::nanoseconds time{};        ///< When the call was made.
+  Kind kind = Kind::Step;                 ///< Which call was made.
+  uint32_t car = 0;                       ///< Car of a fleet, 0 otherwise.
+  int floor = 0;                          ///< Floor of a request.
+  Direction direction = Direction::IDLE;  ///< Direction of a hall call.
+};
+
+/**
+ * @class TraceRecorder
+ * @brief Appends calls to a compact binary trace.
+ *
+ * The trace starts with a five-byte header ("ELTR" and a version byte).
+ * Each record is a tag byte holding the kind and direction (IDLE for
+ * internal requests and steps), followed by varints: the time since the
+ * previous record (zigzag-encoded, so clocks may step back) and, for
+ * requests, the car and the zigzag-encoded floor.
+ * A step a few milliseconds after the previous record takes four bytes.
+ * Recording does not validate floors, so failed calls replay as failures.
+ */
+class TraceRecorder {
+ public:
+  TraceRecorder();
+
+  /// @brief Records addInternalRequest(floor) on a car.
+  void recordInternalRequest(std::chrono::nanoseconds time, int floor,
+                             uint32_t car = 0);
+
+  /// @brief Records addExternalRequest(floor, direction) on a car.
+  void recordExternalRequest(std::chrono::nanoseconds time, int floor,
+                             Direction direction = Direction::IDLE,
+                             uint32_t car = 0);
+
+  /// @brief Records move(), or stepAll() of a fleet.
+  void recordStep(std::chrono::nanoseconds time);
+
+  /// @return The trace recorded so far.
+  [[nodiscard]] std::span<const std::byte> bytes() const noexcept {
+    return bytes_;
+  }
+
+  /**
+   * @brief Writes the trace to a file, replacing it.
+   * @param path Location of the file.
+   * @return The system error that prevented writing, if any.
+   */
+  std::expected<void, std::error_code> save(
+      const std::filesystem::path& path) const;
+
+ private:
+  std::vector<std::byte> bytes_;        ///< Header and records.
+  std::chrono::nanoseconds last_time_;  ///< Time of the latest record.
+
+  // Appends the tag and time delta shared by every record.
+  void appendHeader(std::chrono::nanoseconds time, uint8_t tag);
+  void appendVarint(uint64_t value);
+};
+
+/**
+ * @class MappedTrace
+ * @brief Read-only memory mapping of a trace file.
+ */
+class MappedTrace {
+ public:
+  /**
+   * @brief Map a trace file
+   * @param path Location of the file.
+   * @return The mapping, or the system error that prevented it.
+   */
+  static std::expected<MappedTrace, std::error_code> open(
+      const std::filesystem::path& path);
+
+  MappedTrace(MappedTrace&& other) noexcept;
+  MappedTrace& operator=(MappedTrace&& other) noexcept;
+  MappedTrace(const MappedTrace&) = delete;
+  MappedTrace& operator=(const MappedTrace&) = delete;
+  ~MappedTrace();
+
+  /// @return The mapped trace.
+  [[nodiscard]] std::span<const std::byte> bytes() const noexcept {
+    return {data_, size_};
+  }
+
+ private:
+  MappedTrace(const std::byte* data, size_t size, void* handle) noexcept;
+
+  // Unmaps and closes, leaving the object empty.
+  void reset() noexcept;
+
+  const std::byte* data_ = nullptr;  ///< Start of the mapping.
+  size_t size_ = 0;                  ///< Length of the mapping.
+  void* handle_ = nullptr;           ///< Mapping handle kept on Windows.
+};
+
+/**
+ * @class TraceDecoder
+ * @brief Reads the records of a trace one by one.
+ */
+class TraceDecoder {
+ public:
+  /**
+   * @brief Starts decoding a trace.
+   * @param trace Trace bytes, e.g. TraceRecorder::bytes() or
+   *        MappedTrace::bytes(); must outlive the decoder.
+   */
+  explicit TraceDecoder(std::span<const std::byte> trace) noexcept;
+
+  /**
+   * @brief Decodes the next record.
+   * @param event Receives the record.
+   * @return std::expected<bool, std::error_code>
+   *         - Success: false once the trace is exhausted.
+   *         - Failure: std::errc::illegal_byte_sequence for a malformed
+   *           trace.
+   */
+  [[nodiscard]] std::expected<bool, std::error_code> next(TraceEvent& event);
+
+ private:
+  const std::byte* position_;           ///< Next byte to decode.
+  const std::byte* end_;                ///< End of the trace.
+  std::chrono::nanoseconds last_time_;  ///< Time of the previous record.
+  bool valid_;                          ///< Header was accepted.
+
+  [[nodiscard]] bool readVarint(uint64_t& value) noexcept;
+};
+
+/**
+ * @brief Calls visit(event) for every record of a trace, in order.
+ * @param trace Trace bytes.
+ * @param visit Callable taking const TraceEvent&.
+ * @return Number of records, or std::errc::illegal_byte_sequence if the
+ *         trace is malformed (after visiting the records before the fault).
+ */
+template <typename Visitor>
+std::expected<size_t, std::error_code> decodeTrace(
+    std::span<const std::byte> trace, Visitor&& visit) {
+  TraceDecoder decoder(trace);
+  TraceEvent event;
+  size_t count = 0;
+  for (;;) {
+    auto more = decoder.next(event);
+    if (!more) {
+      return std::unexpected(more.error());
+    }
+    if (!*more) {
+      return count;
+    }
+    visit(static_cast<const TraceEvent&>(event));
+    ++count;
+  }
+}
+
+/**
+ * @brief Replays a trace through a controller.
+ * @param trace Trace bytes; records for cars other than 0 are skipped.
+ * @param controller Controller receiving the calls.
+ * @return Number of records, or the error of decodeTrace().
+ */
+template <int MinFloor, int MaxFloor, typename Policy>
+std::expected<size_t, std::error_code> replayTrace(
+    std::span<const std::byte> trace,
+    BasicElevatorController<MinFloor, MaxFloor, Policy>& controller) {
+  return decodeTrace(trace, [&controller](const TraceEvent& event) {
+    if (event.kind == TraceEvent::Kind::Step) {
+      controller.move();
+    } else if (event.car != 0) {
+      return;
+    } else if (event.kind == TraceEvent::Kind::InternalRequest) {
+      (void)controller.addInternalRequest(event.floor);
+    } else {
+      (void)controller.addExternalRequest(event.floor, event.direction);
+    }
+  });
+}
+
+/**
+ * @brief Replays a trace through a fleet.
+ * @param trace Trace bytes; records for cars beyond the fleet are skipped.
+ * @param fleet Fleet receiving the calls; steps become stepAll().
+ * @return Number of records, or the error of decodeTrace().
+ */
+template <int MinFloor, int MaxFloor>
+std::expected<size_t, std::error_code> replayTrace(
+    std::span<const std::byte> trace, BasicFleet<MinFloor, MaxFloor>& fleet) {
+  return decodeTrace(trace, [&fleet](const TraceEvent& event) {
+    if (event.kind == TraceEvent::Kind::Step) {
+      fleet.stepAll();
+    } else if (event.car >= fleet.size()) {
+      return;
+    } else if (event.kind == TraceEvent::Kind::InternalRequest) {
+      (void)fleet.addInternalRequest(event.car, event.floor);
+    } else {
+      (void)fleet.addExternalRequest(event.car, event.floor, event.direction);
+    }
+  });
+}
+
+}  // namespace elevator
@@ -0,0 +1,242 @@
+/**
+ * @file traffic_study.hpp
+ * @brief Implements a parallel Monte-Carlo runner over traffic scenarios.
+ */
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "elevator_simulator.hpp"
+
+namespace elevator {
+
+/**
+ * @enum TrafficPattern
+ * @brief Shape of the passenger flow in a scenario.
+ *
+ * @var TrafficPattern::UpPeak
+ *      Morning: everybody rides from the lobby (lowest floor) up.
+ * @var TrafficPattern::TwoWay
+ *      Lunch: trips to and from the lobby in equal parts, plus some trips
+ *      between upper floors.
+ * @var TrafficPattern::DownPeak
+ *      Evening: everybody rides down to the lobby.
+ */
+enum class TrafficPattern : uint8_t { UpPeak, TwoWay, DownPeak };
+
+/**
+ * @struct Scenario
+ * @brief Randomized traffic a study runs many times.
+ */
+struct Scenario {
+  TrafficPattern pattern = TrafficPattern::UpPeak;  ///< Passenger flow.
+  int passengers = 200;        ///< Passengers per run.
+  Seconds duration{3600.0};    ///< Period over which they arrive.
+  Timing timing{};             ///< Mechanical timings of the car.
+};
+
+/**
+ * @struct TrafficStatistics
+ * @brief Wait and journey totals over any number of trips.
+ *
+ * Times are summed in whole microseconds, so merging partial statistics
+ * gives the same result in any order and for any split of the runs.
+ */
+struct TrafficStatistics {
+  /// A wait at least this long counts as a long wait.
+  static constexpr std::chrono::seconds kLongWait{60};
+
+  size_t runs = 0;                        ///< Scenarios simulated.
+  size_t trips = 0;                       ///< Passengers served.
+  size_t long_waits = 0;                  ///< Waits of kLongWait or more.
+  std::chrono::microseconds total_wait{};     ///< Sum of waits.
+  std::chrono::microseconds max_wait{};       ///< Longest wait.
+  std::chrono::microseconds total_journey{};  ///< Sum of journeys.
+  std::chrono::microseconds max_journey{};    ///< Longest journey.
+
+  /// @brief Adds one trip.
+  void add(const Trip& trip) noexcept {
+    const auto wait = std::chrono::round<std::chrono::microseconds>(trip.wait);
+    const auto journey =
+        std::chrono::round<std::chrono::microseconds>(trip.journey);
+    ++trips;
+    long_waits += wait >= kLongWait ? 1U : 0U;
+    total_wait += wait;
+    max_wait = std::max(max_wait, wait);
+    total_journey += journey;
+    max_journey = std::max(max_journey, journey);
+  }
+
+  /// @brief Adds the trips counted by another accumulator.
+  void merge(const TrafficStatistics& other) noexcept {
+    runs += other.runs;
+    trips += other.trips;
+    long_waits += other.long_waits;
+    total_wait += other.total_wait;
+    max_wait = std::max(max_wait, other.max_wait);
+    total_journey += other.total_journey;
+    max_journey = std::max(max_journey, other.max_journey);
+  }
+
+  /// @return Mean wait, zero without trips.
+  [[nodiscard]] Seconds meanWait() const noexcept {
+    return trips == 0 ? Seconds{} : Seconds{total_wait} / trips;
+  }
+
+  /// @return Mean journey, zero without trips.
+  [[nodiscard]] Seconds meanJourney() const noexcept {
+    return trips == 0 ? Seconds{} : Seconds{total_journey} / trips;
+  }
+};
+
+/**
+ * @class BasicTrafficStudy
+ * @brief Simulates a scenario for many seeds in parallel.
+ * @tparam MinFloor Lowest floor of the building.
+ * @tparam MaxFloor Highest floor of the building.
+ * @tparam Policy SchedulingPolicy of the simulated car.
+ *
+ * Every seed yields one independent run on its own simulator and controller.
+ * Worker threads claim seeds from a shared counter, so fast and slow runs
+ * balance out, and keep their own TrafficStatistics; the only shared writes
+ * are the counter and one merge per thread at the end. A given seed always
+ * produces the same traffic on a given standard library.
+ */
+template <int MinFloor, int MaxFloor, typename Policy = LookPolicy>
+class BasicTrafficStudy {
+ public:
+  /// Floor passengers enter and leave the building by.
+  static constexpr int kLobby = MinFloor;
+
+  /**
+   * @brief Creates a study of the given scenario.
+   * @param scenario Traffic to simulate.
+   */
+  explicit BasicTrafficStudy(const Scenario& scenario) noexcept
+      : scenario_(scenario) {}
+
+  /**
+   * @brief Generates the traffic of one run.
+   * @param seed Seed of the run.
+   * @return Passengers, ordered by arrival.
+   */
+  [[nodiscard]] std::vector<Passenger> traffic(uint64_t seed) const;
+
+  /**
+   * @brief Simulates runs with seeds first_seed, first_seed + 1, ...
+   * @param first_seed Seed of the first run.
+   * @param runs Number of runs.
+   * @param threads Worker threads; 0 uses every hardware thread.
+   * @return Statistics over all trips of all runs.
+   */
+  [[nodiscard]] TrafficStatistics run(uint64_t first_seed, size_t runs,
+                                      unsigned threads = 0) const;
+
+ private:
+  const Scenario scenario_;  ///< Traffic to simulate.
+
+  // Fills passengers with the traffic of one seed.
+  void fillTraffic(uint64_t seed, std::vector<Passenger>& passengers) const;
+};
+
+/// Study for the reference building with floors 1-9.
+using TrafficStudy = BasicTrafficStudy<1, 9>;
+
+template <int MinFloor, int MaxFloor, typename Policy>
+std::vector<Passenger> BasicTrafficStudy<MinFloor, MaxFloor, Policy>::traffic(
+    uint64_t seed) const {
+  std::vector<Passenger> passengers;
+  fillTraffic(seed, passengers);
+  return passengers;
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+void BasicTrafficStudy<MinFloor, MaxFloor, Policy>::fillTraffic(
+    uint64_t seed, std::vector<Passenger>& passengers) const {
+  // Share of two-way trips between upper floors.
+  constexpr double kInterfloorShare = 0.1;
+
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> time(0.0, scenario_.duration.count());
+  std::uniform_real_distribution<double> share(0.0, 1.0);
+  // A single-floor building only has the lobby.
+  std::uniform_int_distribution<int> upper(std::min(kLobby + 1, MaxFloor),
+                                           MaxFloor);
+
+  passengers.resize(static_cast<size_t>(std::max(scenario_.passengers, 0)));
+  for (Passenger& passenger : passengers) {
+    passenger.arrival = Seconds{time(rng)};
+    TrafficPattern pattern = scenario_.pattern;
+    if (pattern == TrafficPattern::TwoWay) {
+      const double pick = share(rng);
+      if (pick < kInterfloorShare) {
+        passenger.origin = upper(rng);
+        do {
+          passenger.destination = upper(rng);
+        } while (passenger.destination == passenger.origin &&
+                 MaxFloor - kLobby > 1);
+        continue;
+      }
+      pattern = pick < (1.0 + kInterfloorShare) / 2 ? TrafficPattern::UpPeak
+                                                    : TrafficPattern::DownPeak;
+    }
+    passenger.origin = pattern == TrafficPattern::UpPeak ? kLobby : upper(rng);
+    passenger.destination =
+        pattern == TrafficPattern::UpPeak ? upper(rng) : kLobby;
+  }
+  std::ranges::sort(passengers, {}, &Passenger::arrival);
+}
+
+template <int MinFloor, int MaxFloor, typename Policy>
+TrafficStatistics BasicTrafficStudy<MinFloor, MaxFloor, Policy>::run(
+    uint64_t first_seed, size_t runs, unsigned threads) const {
+  if (threads == 0) {
+    threads = std::max(std::thread::hardware_concurrency(), 1U);
+  }
+  const size_t workers = std::min<size_t>(threads, runs);
+
+  std::atomic<size_t> next_run{0};
+  std::vector<TrafficStatistics> partials(workers);
+  {
+    std::vector<std::jthread> pool;
+    pool.reserve(workers);
+    for (size_t w = 0; w < workers; ++w) {
+      pool.emplace_back([this, &next_run, &partial = partials[w], first_seed,
+                         runs] {
+        BasicElevatorSimulator<MinFloor, MaxFloor, Policy> simulator(
+            scenario_.timing);
+        std::vector<Passenger> passengers;
+        TrafficStatistics local;
+        for (size_t i = next_run.fetch_add(1, std::memory_order_relaxed);
+             i < runs; i = next_run.fetch_add(1, std::memory_order_relaxed)) {
+          fillTraffic(first_seed + i, passengers);
+          // Generated floors are always valid.
+          const auto report = simulator.run(passengers);
+          ++local.runs;
+          for (const Trip& trip : report->trips) {
+            local.add(trip);
+          }
+        }
+        partial = local;
+      });
+    }
+  }  // Joins the pool.
+
+  TrafficStatistics total;
+  for (const TrafficStatistics& partial : partials) {
+    total.merge(partial);
+  }
+  return total;
+}
+
+// The reference building is compiled once, in traffic_study.cpp.
+extern template class BasicTrafficStudy<1, 9>;
+
+}  // namespace elevator
@@ -0,0 +1,202 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../include/elevator_controller.hpp"
+
+using elevator::BasicElevatorController;
+using elevator::Direction;
+using elevator::Request;
+
+// Prepared controllers cycled through, so the branch predictor cannot
+// learn a single request pattern.
+static constexpr size_t kScenarios = 64;
+
+// Benchmark arguments, in order.
+enum Arg : uint8_t {
+  kDensity,  // pending requests in percent of the floors
+};
+
+// Reports the mean cost of one of ops operations in nanoseconds. The value
+// is scaled so that the inverted rate (seconds per value) comes out in ns.
+static benchmark::Counter ns_per_op(size_t ops) {
+  return benchmark::Counter(
+      static_cast<double>(ops) * 1e-9,
+      benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+template <typename Car>
+static size_t request_count(const benchmark::State& state) {
+  const auto density = static_cast<size_t>(state.range(kDensity));
+  return std::max<size_t>(Car::kFloorCount * density / 100, 1);
+}
+
+// Random mix of passenger requests and hall calls in both directions.
+template <typename Car>
+static std::vector<Request> make_requests(size_t count, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> floor(Car::kMinFloor, Car::kMaxFloor);
+  std::uniform_int_distribution<int> kind(0, 3);
+  std::vector<Request> requests(count);
+  for (Request& request : requests) {
+    request.floor = floor(rng);
+    switch (kind(rng)) {
+      case 0:
+      case 1:
+        request.kind = Request::Kind::Internal;
+        break;
+      case 2:
+        request.kind = Request::Kind::External;
+        request.direction = Direction::UP;
+        break;
+      default:
+        request.kind = Request::Kind::External;
+        request.direction = Direction::DOWN;
+        break;
+    }
+  }
+  return requests;
+}
+
+template <typename Car>
+static void add_request(Car& car, const Request& request) {
+  if (request.kind == Request::Kind::Internal) {
+    benchmark::DoNotOptimize(car.addInternalRequest(request.floor));
+  } else {
+    benchmark::DoNotOptimize(
+        car.addExternalRequest(request.floor, request.direction));
+  }
+}
+
+// Busy cars, each with its own pending requests, parked on the lowest floor.
+template <typename Car>
+static std::vector<Car> make_cars(size_t requests) {
+  std::vector<Car> cars(kScenarios);
+  for (size_t i = 0; i < cars.size(); ++i) {
+    for (const Request& request :
+         make_requests<Car>(requests, static_cast<uint32_t>(i))) {
+      add_request(cars[i], request);
+    }
+  }
+  return cars;
+}
+
+// One addInternalRequest()/addExternalRequest() per request on a fresh car.
+template <typename Car>
+static void BM_AddRequest(benchmark::State& state) {
+  const size_t count = request_count<Car>(state);
+  const std::vector<Request> requests = make_requests<Car>(count, 0);
+  for (auto _ : state) {
+    Car car;
+    for (const Request& request : requests) {
+      add_request(car, request);
+    }
+    benchmark::DoNotOptimize(car);
+  }
+  const auto ops = static_cast<size_t>(state.iterations()) * count;
+  state.SetItemsProcessed(static_cast<int64_t>(ops));
+  state.counters["ns_per_op"] = ns_per_op(ops);
+}
+
+// The same requests through one addRequests() call.
+template <typename Car>
+static void BM_AddRequests(benchmark::State& state) {
+  const size_t count = request_count<Car>(state);
+  const std::vector<Request> requests = make_requests<Car>(count, 0);
+  for (auto _ : state) {
+    Car car;
+    benchmark::DoNotOptimize(car.addRequests(requests));
+    benchmark::DoNotOptimize(car);
+  }
+  const auto ops = static_cast<size_t>(state.iterations()) * count;
+  state.SetItemsProcessed(static_cast<int64_t>(ops));
+  state.counters["ns_per_op"] = ns_per_op(ops);
+}
+
+// move() until every request is served; one op is one move().
+template <typename Car>
+static void BM_Move(benchmark::State& state) {
+  const std::vector<Car> cars = make_cars<Car>(request_count<Car>(state));
+  size_t moves = 0;
+  size_t next = 0;
+  for (auto _ : state) {
+    Car car = cars[next];
+    next = (next + 1) % cars.size();
+    while (car.hasRequests()) {
+      car.move();
+      ++moves;
+    }
+    benchmark::DoNotOptimize(car);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(moves));
+  state.counters["ns_per_op"] = ns_per_op(moves);
+}
+
+// advanceToNextStop() until every request is served; one op is one full
+// trip, from the first request to the car parking.
+template <typename Car>
+static void BM_Trip(benchmark::State& state) {
+  const std::vector<Car> cars = make_cars<Car>(request_count<Car>(state));
+  size_t stops = 0;
+  size_t next = 0;
+  for (auto _ : state) {
+    Car car = cars[next];
+    next = (next + 1) % cars.size();
+    while (car.advanceToNextStop() != 0) {
+      ++stops;
+    }
+    benchmark::DoNotOptimize(car);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["ns_per_op"] =
+      ns_per_op(static_cast<size_t>(state.iterations()));
+  state.counters["stops"] = benchmark::Counter(
+      static_cast<double>(stops), benchmark::Counter::kAvgIterations);
+}
+
+static void density_args(benchmark::internal::Benchmark* bench) {
+  bench->ArgNames({"density"});
+  for (const int64_t density : {5, 25, 100}) {
+    bench->Arg(density);
+  }
+}
+
+// Reference building, one word and several words of FloorSet storage.
+using Low = BasicElevatorController<1, 9>;
+using Mid = BasicElevatorController<1, 64>;
+using High = BasicElevatorController<1, 200>;
+using LowScan = BasicElevatorController<1, 9, elevator::ScanPolicy>;
+using HighScan = BasicElevatorController<1, 200, elevator::ScanPolicy>;
+using LowNearest =
+    BasicElevatorController<1, 9, elevator::NearestRequestPolicy>;
+using HighNearest =
+    BasicElevatorController<1, 200, elevator::NearestRequestPolicy>;
+
+BENCHMARK_TEMPLATE(BM_AddRequest, Low)->Apply(density_args);
+BENCHMARK_TEMPLATE(BM_AddRequest, Mid)->Apply(density_args);
+BENCHMARK_TEMPLATE(BM_AddRequest, High)->Apply(density_args);
+BENCHMARK_TEMPLATE(BM_AddRequests, Low)->Apply(density_args);
+BENCHMARK_TEMPLATE(BM_AddRequests, Mid)->Apply(density_args);
+BENCHMARK_TEMPLATE(BM_AddRequests, High)->Apply(density_args);
+
+BENCHMARK_TEMPLATE(BM_Move, Low)->Apply(density_args);
+BENCHMARK_TEMPLATE(BM_Move, Mid)->Apply(density_args);
+BENCHMARK_TEMPLATE(BM_Move, High)->Apply(density_args);
+BENCHMARK_TEMPLATE(BM_Move, LowScan)->Apply(density_args);
+BENCHMARK_TEMPLATE(BM_Move, HighScan)->Apply(density_args);
+BENCHMARK_TEMPLATE(BM_Move, LowNearest)->Apply(density_args);
+BENCHMARK_TEMPLATE(BM_Move, HighNearest)->Apply(density_args);
+
+BENCHMARK_TEMPLATE(BM_Trip, Low)->Apply(density_args);
+BENCHMARK_TEMPLATE(BM_Trip, Mid)->Apply(density_args);
+BENCHMARK_TEMPLATE(BM_Trip, High)->Apply(density_args);
+BENCHMARK_TEMPLATE(BM_Trip, LowScan)->Apply(density_args);
+BENCHMARK_TEMPLATE(BM_Trip, HighScan)->Apply(density_args);
+BENCHMARK_TEMPLATE(BM_Trip, LowNearest)->Apply(density_args);
+BENCHMARK_TEMPLATE(BM_Trip, HighNearest)->Apply(density_args);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,7 @@
+#include "../include/elevator_group.hpp"
+
+namespace elevator {
+
+template class BasicElevatorGroup<1, 9>;
+
+}  // namespace elevator
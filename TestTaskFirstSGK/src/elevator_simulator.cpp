@@ -0,0 +1,7 @@
+#include "../include/elevator_simulator.hpp"
+
+namespace elevator {
+
+template class BasicElevatorSimulator<1, 9>;
+
+}  // namespace elevator
@@ -0,0 +1,7 @@
+#include "../include/fleet.hpp"
+
+namespace elevator {
+
+template class BasicFleet<1, 9>;
+
+}  // namespace elevator
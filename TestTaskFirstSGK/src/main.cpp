@@ -1,8 +1,21 @@
 #include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <span>
+#include <vector>
 
 #include "../include/direction.hpp"
 #include "../include/elevator_controller.hpp"
+#include "../include/elevator_group.hpp"
+#include "../include/elevator_simulator.hpp"
+#include "../include/fleet.hpp"
+#include "../include/trace.hpp"
+#include "../include/floor_set.hpp"
+#include "../include/telemetry.hpp"
+#include "../include/traffic_study.hpp"
 
 namespace {
 constexpr int kFirstTestFloor = 3;
@@ -13,6 +26,23 @@ constexpr int kFifthTestFloor = 7;
 constexpr int kSixthTestFloor = 4;
 constexpr int kSeventhTestFloor = 2;
 constexpr int kEighthTestFloor = 6;
+
+// Growable stream for TelemetrySink, refusing every reserve once full.
+struct TestStream {
+  std::vector<std::byte> bytes;
+  size_t capacity = SIZE_MAX;
+  size_t reserves = 0;
+
+  std::span<std::byte> reserve(size_t count) {
+    if (bytes.size() + count > capacity) {
+      return {};
+    }
+    ++reserves;
+    bytes.resize(bytes.size() + count);
+    return {bytes.data() + bytes.size() - count, count};
+  }
+  void commit(size_t /*count*/) {}
+};
 }  // namespace
 
 void runTests() {
@@ -95,6 +125,398 @@ void runTests() {
     assert(ec.getCurrentDirection() == elevator::Direction::IDLE);
   }
 
+  // Test 4
+  {
+    elevator::FloorSet<elevator::ElevatorController::kFloorCount> floors;
+    assert(floors.empty());
+    assert(!floors.nearestAbove(0) && !floors.nearestBelow(0));
+
+    floors.insert(kThirdTestFloor);
+    floors.insert(kSecondTestFloor);
+    assert(floors.contains(kSecondTestFloor));
+    assert(floors.anyAbove(kFirstTestFloor));
+    assert(floors.anyBelow(kFirstTestFloor));
+    assert(floors.nearestAbove(kFirstTestFloor) == kSecondTestFloor);
+    assert(floors.nearestBelow(kFirstTestFloor) == kThirdTestFloor);
+
+    floors.erase(kThirdTestFloor);
+    assert(!floors.anyBelow(kFirstTestFloor));
+
+    // Spans several storage words.
+    constexpr int kTallFloors = 120;
+    elevator::FloorSet<kTallFloors> tall;
+    tall.insert(kThirdTestFloor);
+    tall.insert(kTallFloors - 1);
+    assert(tall.nearestAbove(kThirdTestFloor) == kTallFloors - 1);
+    assert(tall.nearestBelow(kTallFloors - 1) == kThirdTestFloor);
+    assert(!tall.anyAbove(kTallFloors - 1));
+  }
+
+  // Test 5
+  {
+    constexpr int kLowestFloor = -2;
+    constexpr int kHighestFloor = 120;
+    elevator::BasicElevatorController<kLowestFloor, kHighestFloor> ec;
+    assert(ec.getCurrentFloor() == kLowestFloor);
+    auto too_high = ec.addExternalRequest(kHighestFloor + 1);
+    auto too_low = ec.addExternalRequest(kLowestFloor - 1);
+    assert(!too_high && !too_low && "Floors outside the building accepted");
+
+    auto result = ec.addExternalRequest(kHighestFloor);
+    assert(result);
+    while (ec.hasRequests()) {
+      ec.move();
+    }
+    assert(ec.getCurrentFloor() == kHighestFloor);
+    assert(ec.errorMessage(elevator::ElevatorError::InvalidFloor, 0) ==
+           "Invalid floor: 0. Must be between -2 and 120");
+  }
+
+  // Test 6
+  {
+    elevator::ElevatorGroup group(2);
+    auto result1 = group.addInternalRequest(0, kFourthTestFloor);  // car 0 -> 9
+    assert(result1);
+    for (int i = 0; i < 4; ++i) {
+      group.step();  // car 0: 1 -> 5
+    }
+    assert(group.car(0).getCurrentFloor() == kSecondTestFloor);
+
+    // Car 0 would have to go up to 9 first; idle car 1 is closer.
+    auto assigned = group.addExternalRequest(kFirstTestFloor);
+    assert(assigned && *assigned == 1);
+    assert(group.assignedCar(kFirstTestFloor) == 1);
+    auto invalid = group.addExternalRequest(kFourthTestFloor + 1);
+    assert(!invalid && "Invalid floor assigned to a car");
+    auto missing = group.addInternalRequest(2, kFirstTestFloor);
+    assert(!missing && missing.error() == elevator::ElevatorError::InvalidCar);
+
+    while (group.hasRequests()) {
+      group.step();
+    }
+    assert(group.car(0).getCurrentFloor() == kFourthTestFloor);
+    assert(group.car(1).getCurrentFloor() == kFirstTestFloor);
+    assert(!group.assignedCar(kFirstTestFloor));
+  }
+
+  // Test 7
+  {
+    using elevator::Direction;
+    elevator::ElevatorController ec;
+    auto result1 = ec.addExternalRequest(kSecondTestFloor, Direction::DOWN);
+    auto result2 = ec.addExternalRequest(kFirstTestFloor, Direction::UP);
+    auto result3 = ec.addInternalRequest(kFifthTestFloor);
+    assert(result1 && result2 && result3);
+    while (ec.getCurrentFloor() != kSecondTestFloor) {
+      ec.move();  // 1 -> 5, picking up the up-call at 3
+    }
+    assert(!ec.hasExternalRequest(kFirstTestFloor, Direction::UP));
+
+    // Heading up to 7, the car leaves the down-call for the return sweep.
+    ec.move();  // 5 -> 6
+    assert(ec.hasExternalRequest(kSecondTestFloor, Direction::DOWN));
+    assert(ec.getCurrentDirection() == Direction::UP);
+    ec.move();  // 6 -> 7, turns around
+    assert(ec.getCurrentDirection() == Direction::DOWN);
+    ec.move();  // 7 -> 6
+    ec.move();  // 6 -> 5
+    assert(!ec.hasRequests());
+    assert(ec.getCurrentDirection() == Direction::IDLE);
+
+    // A parked car serves a call on its own floor either way.
+    auto result4 = ec.addExternalRequest(kSecondTestFloor, Direction::UP);
+    assert(result4);
+    assert(!ec.hasRequests());
+
+    // A down-call below an up-bound car costs it the full return sweep.
+    elevator::ElevatorGroup group(2);
+    auto result5 = group.addInternalRequest(0, kFourthTestFloor);
+    assert(result5);
+    for (int i = 0; i < 3; ++i) {
+      group.step();  // car 0: 1 -> 4
+    }
+    auto assigned =
+        group.addExternalRequest(kEighthTestFloor, Direction::DOWN);
+    assert(assigned && *assigned == 1);
+    assert(group.assignedCar(kEighthTestFloor, Direction::DOWN) == 1);
+    assert(!group.assignedCar(kEighthTestFloor));
+  }
+
+  // Test 8
+  {
+    using elevator::Seconds;
+    // 1.5s per floor, 2s per run, 4s doors.
+    const elevator::Passenger passengers[] = {
+        {Seconds{0}, kThirdTestFloor, kSecondTestFloor},  // 1 -> 5
+        {Seconds{1}, kFirstTestFloor, kThirdTestFloor},   // 3 -> 1
+    };
+    elevator::ElevatorSimulator simulator;
+    auto report = simulator.run(passengers);
+    assert(report);
+
+    // The down-call at 3 waits until the car has turned around at 5.
+    assert(report->trips[0].wait == Seconds{0});
+    assert(report->trips[0].journey == Seconds{12});
+    assert(report->trips[1].wait == Seconds{20});
+    assert(report->trips[1].journey == Seconds{29});
+    assert(report->end_time == Seconds{30});
+    assert(report->stops == 4);
+    assert(report->floors_travelled == 8);
+
+    const elevator::Passenger invalid[] = {
+        {Seconds{0}, kThirdTestFloor, kFourthTestFloor + 1}};
+    auto rejected = simulator.run(invalid);
+    assert(!rejected && "Passenger to a missing floor accepted");
+  }
+
+  // Test 9
+  {
+    constexpr int kRuns = 8;
+    elevator::TrafficStudy study({.pattern = elevator::TrafficPattern::TwoWay,
+                                  .passengers = 50});
+    for ([[maybe_unused]] const auto& passenger : study.traffic(1)) {
+      assert(passenger.origin != passenger.destination);
+    }
+
+    // The split across threads does not change the result.
+    [[maybe_unused]] const auto serial = study.run(1, kRuns, 1);
+    [[maybe_unused]] const auto parallel = study.run(1, kRuns, 4);
+    assert(serial.runs == kRuns && serial.trips == kRuns * 50);
+    assert(serial.total_wait == parallel.total_wait);
+    assert(serial.max_journey == parallel.max_journey);
+    assert(serial.meanJourney() > serial.meanWait());
+  }
+
+  // Test 10
+  {
+    using Kind = elevator::Request::Kind;
+    const elevator::Request requests[] = {
+        {Kind::Internal, kFifthTestFloor},
+        {Kind::External, kFourthTestFloor + 1},
+        {Kind::External, kFirstTestFloor, elevator::Direction::DOWN},
+        {Kind::Internal, kThirdTestFloor - 1},
+    };
+    elevator::ElevatorController ec;
+    const auto result = ec.addRequests(requests);
+    assert(result.accepted == 2);
+    assert(!result.error(0) && !result.error(2));
+    assert(result.error(1) == elevator::ElevatorError::InvalidFloor);
+    assert(result.error(3) == elevator::ElevatorError::InvalidFloor);
+    assert(ec.getCurrentDirection() == elevator::Direction::UP);
+    assert(ec.pendingStopCount() == 2);
+    const auto empty = ec.addRequests({});
+    assert(empty.accepted == 0 && empty.rejected.empty());
+  }
+
+  // Test 11
+  {
+    elevator::ElevatorController ec;
+    [[maybe_unused]] const int idle = ec.advanceToNextStop();
+    assert(!ec.nextStop() && idle == 0);
+    auto result1 = ec.addInternalRequest(kFifthTestFloor);
+    auto result2 =
+        ec.addExternalRequest(kFirstTestFloor, elevator::Direction::DOWN);
+    auto result3 = ec.addInternalRequest(kSeventhTestFloor);
+    assert(result1 && result2 && result3);
+
+    // The down-call at 3 is passed on the way up and served on the return.
+    assert(ec.nextStop() == kSeventhTestFloor);
+    [[maybe_unused]] const int first = ec.advanceToNextStop();
+    assert(first == 1);
+    assert(ec.nextStop() == kFifthTestFloor);
+    [[maybe_unused]] const int second = ec.advanceToNextStop();
+    assert(second == kFifthTestFloor - kSeventhTestFloor);
+    assert(ec.getCurrentDirection() == elevator::Direction::DOWN);
+    assert(ec.nextStop() == kFirstTestFloor);
+    [[maybe_unused]] const int third = ec.advanceToNextStop();
+    assert(third == kFifthTestFloor - kFirstTestFloor);
+    assert(!ec.hasRequests());
+  }
+
+  // Test 12
+  {
+    using elevator::Direction;
+    constexpr size_t kCars = 20;  // More than one block of lanes.
+    elevator::Fleet fleet(kCars);
+    std::vector<elevator::ElevatorController> cars(kCars);
+    for (size_t i = 0; i < kCars; ++i) {
+      const int floor = kThirdTestFloor + static_cast<int>(i % 9);
+      const auto direction = static_cast<Direction>(i % 3);
+      auto result1 = fleet.addInternalRequest(i, kFourthTestFloor - floor + 1);
+      auto result2 = cars[i].addInternalRequest(kFourthTestFloor - floor + 1);
+      auto result3 = fleet.addExternalRequest(i, floor, direction);
+      auto result4 = cars[i].addExternalRequest(floor, direction);
+      assert(result1 && result2 && result3 && result4);
+    }
+    auto invalid = fleet.addInternalRequest(0, kFourthTestFloor + 1);
+    assert(!invalid && "Invalid floor accepted by the fleet");
+
+    // Every car follows its controller step by step.
+    for (int step = 0; step < 2 * kFourthTestFloor; ++step) {
+      fleet.stepAll();
+      for (size_t i = 0; i < kCars; ++i) {
+        cars[i].move();
+        assert(fleet.getCurrentFloor(i) == cars[i].getCurrentFloor());
+        assert(fleet.getCurrentDirection(i) ==
+               cars[i].getCurrentDirection());
+        assert(fleet.hasRequests(i) == cars[i].hasRequests());
+      }
+    }
+    assert(!fleet.hasRequests(kCars - 1));
+  }
+
+  // Test 13
+  {
+    using std::chrono::milliseconds;
+    elevator::ElevatorController live;
+    elevator::TraceRecorder recorder;
+    auto result1 =
+        live.addExternalRequest(kSecondTestFloor, elevator::Direction::UP);
+    assert(result1);
+    recorder.recordExternalRequest(milliseconds{0}, kSecondTestFloor,
+                                   elevator::Direction::UP);
+    auto result2 = live.addInternalRequest(kFourthTestFloor + 1);
+    assert(!result2);
+    recorder.recordInternalRequest(milliseconds{3}, kFourthTestFloor + 1);
+    for (int i = 0; i < 3; ++i) {
+      live.move();
+      recorder.recordStep(milliseconds{5 + i});
+    }
+
+    const auto path = std::filesystem::temp_directory_path() /
+                      "elevator_trace_test.bin";
+    auto saved = recorder.save(path);
+    assert(saved && "Failed to save the trace");
+    auto mapped = elevator::MappedTrace::open(path);
+    assert(mapped);
+    std::filesystem::remove(path);
+
+    // The replayed controller ends where the live one did.
+    elevator::ElevatorController replayed;
+    auto replayed_events = elevator::replayTrace(mapped->bytes(), replayed);
+    assert(replayed_events == 5);
+    assert(replayed.getCurrentFloor() == live.getCurrentFloor());
+    assert(replayed.getCurrentDirection() == live.getCurrentDirection());
+    elevator::Fleet fleet(1);
+    auto fleet_events = elevator::replayTrace(recorder.bytes(), fleet);
+    assert(fleet_events == 5);
+    assert(fleet.getCurrentFloor(0) == live.getCurrentFloor());
+
+    milliseconds last{};
+    std::vector<elevator::Direction> directions;
+    auto decoded_events = elevator::decodeTrace(
+        recorder.bytes(), [&](const elevator::TraceEvent& event) {
+          last = std::chrono::duration_cast<milliseconds>(event.time);
+          directions.push_back(event.direction);
+        });
+    assert(decoded_events == 5);
+    assert(last == milliseconds{7});
+    // Only the hall call carries a direction.
+    assert(directions[0] == elevator::Direction::UP);
+    for (size_t i = 1; i < directions.size(); ++i) {
+      assert(directions[i] == elevator::Direction::IDLE);
+    }
+    auto truncated = elevator::replayTrace(recorder.bytes().first(6), replayed);
+    assert(!truncated && "Truncated trace replayed");
+  }
+
+  // Test 14
+  {
+    // LOOK turns at the last request ahead, SCAN at the end of the shaft.
+    elevator::ElevatorController look;
+    elevator::BasicElevatorController<1, 9, elevator::ScanPolicy> scan;
+    auto result1 = look.addInternalRequest(kSecondTestFloor);
+    auto result2 = scan.addInternalRequest(kSecondTestFloor);
+    assert(result1 && result2);
+    for (int i = 0; i < 3; ++i) {
+      look.move();
+      scan.move();
+    }
+    auto result3 = look.addInternalRequest(kSeventhTestFloor);
+    auto result4 = scan.addInternalRequest(kSeventhTestFloor);
+    assert(result3 && result4);
+    [[maybe_unused]] auto look_moves = look.advanceToNextStop();
+    [[maybe_unused]] auto scan_moves = scan.advanceToNextStop();
+    assert(look_moves == 1 && scan_moves == 1);
+    assert(look.getCurrentDirection() == elevator::Direction::DOWN);
+    assert(scan.getCurrentDirection() == elevator::Direction::UP);
+    assert(scan.nextStop() == kSeventhTestFloor);
+    scan_moves = scan.advanceToNextStop();
+    assert(scan_moves == 11);
+    assert(!scan.hasRequests());
+
+    // Nearest-request turns back for a closer floor.
+    elevator::BasicElevatorController<1, 9, elevator::NearestRequestPolicy>
+        nearest;
+    auto result5 = nearest.addInternalRequest(kFourthTestFloor);
+    assert(result5);
+    for (int i = 0; i < 3; ++i) {
+      nearest.move();
+    }
+    auto result6 = nearest.addInternalRequest(kFirstTestFloor);
+    assert(result6);
+    assert(nearest.getCurrentDirection() == elevator::Direction::DOWN);
+    assert(nearest.nextStop() == kFirstTestFloor);
+
+    elevator::BasicElevatorSimulator<1, 9, elevator::ScanPolicy> simulator;
+    const std::vector<elevator::Passenger> passengers = {
+        {elevator::Seconds{0.0}, kThirdTestFloor, kFifthTestFloor},
+        {elevator::Seconds{1.0}, kSixthTestFloor, kSeventhTestFloor}};
+    const auto report = simulator.run(passengers);
+    assert(report && report->trips.size() == passengers.size());
+  }
+
+  // Test 15
+  {
+    using Sink = elevator::TelemetrySink<TestStream>;
+    TestStream stream;
+    Sink sink(stream, 2);
+    std::vector<elevator::ElevatorController> cars(2);
+    auto result1 = cars[0].addInternalRequest(kFourthTestFloor);
+    auto result2 = cars[1].addInternalRequest(kSecondTestFloor);
+    auto result3 = cars[1].addInternalRequest(kFifthTestFloor);
+    assert(result1 && result2 && result3);
+    for (size_t step = 0; step < Sink::kBlockRecords; ++step) {
+      for (size_t car = 0; car < cars.size(); ++car) {
+        sink.record(car, std::chrono::nanoseconds{step}, cars[car]);
+        cars[car].move();
+      }
+    }
+    // One reserve per full block, each holding one car.
+    assert(stream.reserves == cars.size());
+    sink.record(0, std::chrono::nanoseconds{-1}, cars[0]);
+    assert(stream.reserves == cars.size());
+    [[maybe_unused]] const bool flushed = sink.flushAll();
+    assert(flushed && stream.reserves == cars.size() + 1);
+    assert(stream.bytes.size() ==
+           (2 * Sink::kBlockRecords + 1) * sizeof(elevator::TelemetryRecord));
+
+    std::vector<elevator::TelemetryRecord> records(
+        stream.bytes.size() / sizeof(elevator::TelemetryRecord));
+    std::memcpy(records.data(), stream.bytes.data(), stream.bytes.size());
+    assert(records[0].car == 0 && records[0].time == 0);
+    assert(records[0].floor == kThirdTestFloor);
+    assert(records[0].direction == elevator::Direction::UP);
+    assert(records[0].pending == 1U << (kFourthTestFloor - 1));
+    [[maybe_unused]] const elevator::TelemetryRecord& second =
+        records[Sink::kBlockRecords];
+    assert(second.car == 1 && second.time == 0);
+    assert(second.pending == (1U << (kSecondTestFloor - 1) |
+                              1U << (kFifthTestFloor - 1)));
+    assert(records[Sink::kBlockRecords + 4].floor == kSecondTestFloor);
+    assert(records.back().time == -1 && records.back().pending == 0);
+    assert(records.back().floor == kFourthTestFloor);
+
+    TestStream full;
+    full.capacity = 0;
+    elevator::TelemetrySink<TestStream> refused(full, 1);
+    refused.record(0, std::chrono::nanoseconds{0}, cars[0]);
+    [[maybe_unused]] auto refused_flush = refused.flush(0);
+    assert(!refused_flush && refused.droppedRecords() == 1);
+    [[maybe_unused]] auto retried_flush = refused.flush(0);
+    assert(retried_flush);
+  }
+
   std::cout << "All tests passed!\n";
 }
 
@@ -0,0 +1,286 @@
+#include "../include/trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <limits>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace elevator {
+
+namespace {
+
+constexpr std::array<std::byte, 5> kTraceHeader = {
+    std::byte{'E'}, std::byte{'L'}, std::byte{'T'}, std::byte{'R'},
+    std::byte{1}};
+
+// Tag byte: kind in bits 0-1, direction in bits 2-3.
+constexpr unsigned kKindMask = 0x3;
+constexpr unsigned kDirectionShift = 2;
+constexpr unsigned kTagMask = 0xF;
+// A uint64_t takes at most ten 7-bit groups.
+constexpr int kMaxVarintBytes = 10;
+
+constexpr uint8_t tagOf(TraceEvent::Kind kind, Direction direction) noexcept {
+  return static_cast<uint8_t>(static_cast<unsigned>(kind) |
+                              static_cast<unsigned>(direction)
+                                  << kDirectionShift);
+}
+
+constexpr uint64_t zigzag(int64_t value) noexcept {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+constexpr int64_t unzigzag(uint64_t value) noexcept {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+std::error_code malformed() noexcept {
+  return std::make_error_code(std::errc::illegal_byte_sequence);
+}
+
+#if defined(_WIN32)
+std::error_code last_error() noexcept {
+  return {static_cast<int>(GetLastError()), std::system_category()};
+}
+#else
+std::error_code last_error() noexcept {
+  return {errno, std::system_category()};
+}
+#endif
+
+}  // namespace
+
+TraceRecorder::TraceRecorder()
+    : bytes_(kTraceHeader.begin(), kTraceHeader.end()), last_time_{} {}
+
+void TraceRecorder::recordInternalRequest(std::chrono::nanoseconds time,
+                                          int floor, uint32_t car) {
+  appendHeader(time,
+               tagOf(TraceEvent::Kind::InternalRequest, Direction::IDLE));
+  appendVarint(car);
+  appendVarint(zigzag(floor));
+}
+
+void TraceRecorder::recordExternalRequest(std::chrono::nanoseconds time,
+                                          int floor, Direction direction,
+                                          uint32_t car) {
+  appendHeader(time, tagOf(TraceEvent::Kind::ExternalRequest, direction));
+  appendVarint(car);
+  appendVarint(zigzag(floor));
+}
+
+void TraceRecorder::recordStep(std::chrono::nanoseconds time) {
+  appendHeader(time, tagOf(TraceEvent::Kind::Step, Direction::IDLE));
+}
+
+std::expected<void, std::error_code> TraceRecorder::save(
+    const std::filesystem::path& path) const {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(bytes_.data()),
+             static_cast<std::streamsize>(bytes_.size()));
+  file.close();
+  if (!file) {
+    return std::unexpected(std::make_error_code(std::errc::io_error));
+  }
+  return {};
+}
+
+void TraceRecorder::appendHeader(std::chrono::nanoseconds time, uint8_t tag) {
+  bytes_.push_back(std::byte{tag});
+  appendVarint(zigzag((time - last_time_).count()));
+  last_time_ = time;
+}
+
+void TraceRecorder::appendVarint(uint64_t value) {
+  while (value >= 0x80) {
+    bytes_.push_back(static_cast<std::byte>(value | 0x80));
+    value >>= 7;
+  }
+  bytes_.push_back(static_cast<std::byte>(value));
+}
+
+std::expected<MappedTrace, std::error_code> MappedTrace::open(
+    const std::filesystem::path& path) {
+#if defined(_WIN32)
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return std::unexpected(last_error());
+  }
+  LARGE_INTEGER length;
+  if (!GetFileSizeEx(file, &length) || length.QuadPart == 0) {
+    const std::error_code error =
+        length.QuadPart == 0
+            ? std::make_error_code(std::errc::illegal_byte_sequence)
+            : last_error();
+    CloseHandle(file);
+    return std::unexpected(error);
+  }
+  HANDLE mapping =
+      CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  // The mapping keeps the file open.
+  CloseHandle(file);
+  if (mapping == nullptr) {
+    return std::unexpected(last_error());
+  }
+  const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (data == nullptr) {
+    const std::error_code error = last_error();
+    CloseHandle(mapping);
+    return std::unexpected(error);
+  }
+  return MappedTrace(static_cast<const std::byte*>(data),
+                     static_cast<size_t>(length.QuadPart), mapping);
+#else
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return std::unexpected(last_error());
+  }
+  struct stat status {};
+  if (::fstat(fd, &status) != 0) {
+    const std::error_code error = last_error();
+    ::close(fd);
+    return std::unexpected(error);
+  }
+  // An empty file cannot be mapped and is no trace either.
+  if (status.st_size == 0) {
+    ::close(fd);
+    return std::unexpected(malformed());
+  }
+
+  const auto size = static_cast<size_t>(status.st_size);
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  const std::error_code error = last_error();
+  // The mapping keeps the file alive.
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return std::unexpected(error);
+  }
+  // Replay reads the trace front to back.
+  ::madvise(data, size, MADV_SEQUENTIAL);
+  return MappedTrace(static_cast<const std::byte*>(data), size, nullptr);
+#endif
+}
+
+MappedTrace::MappedTrace(const std::byte* data, size_t size,
+                         void* handle) noexcept
+    : data_(data), size_(size), handle_(handle) {}
+
+MappedTrace::MappedTrace(MappedTrace&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      handle_(std::exchange(other.handle_, nullptr)) {}
+
+MappedTrace& MappedTrace::operator=(MappedTrace&& other) noexcept {
+  if (this != &other) {
+    reset();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    handle_ = std::exchange(other.handle_, nullptr);
+  }
+  return *this;
+}
+
+MappedTrace::~MappedTrace() { reset(); }
+
+void MappedTrace::reset() noexcept {
+  if (data_ == nullptr) {
+    return;
+  }
+#if defined(_WIN32)
+  UnmapViewOfFile(data_);
+  CloseHandle(static_cast<HANDLE>(handle_));
+#else
+  ::munmap(const_cast<std::byte*>(data_), size_);
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  handle_ = nullptr;
+}
+
+TraceDecoder::TraceDecoder(std::span<const std::byte> trace) noexcept
+    : position_(trace.data()),
+      end_(trace.data() + trace.size()),
+      last_time_{},
+      valid_(trace.size() >= kTraceHeader.size() &&
+             std::equal(kTraceHeader.begin(), kTraceHeader.end(),
+                        trace.begin())) {
+  if (valid_) {
+    position_ += kTraceHeader.size();
+  }
+}
+
+std::expected<bool, std::error_code> TraceDecoder::next(TraceEvent& event) {
+  if (!valid_) {
+    return std::unexpected(malformed());
+  }
+  if (position_ == end_) {
+    return false;
+  }
+
+  const auto tag = static_cast<unsigned>(*position_++);
+  const unsigned kind = tag & kKindMask;
+  const unsigned direction = tag >> kDirectionShift;
+  uint64_t delta = 0;
+  if ((tag & ~kTagMask) != 0 ||
+      kind > static_cast<unsigned>(TraceEvent::Kind::Step) ||
+      direction > static_cast<unsigned>(Direction::IDLE) ||
+      !readVarint(delta)) {
+    valid_ = false;
+    return std::unexpected(malformed());
+  }
+  last_time_ += std::chrono::nanoseconds{unzigzag(delta)};
+  event.time = last_time_;
+  event.kind = static_cast<TraceEvent::Kind>(kind);
+  event.direction = static_cast<Direction>(direction);
+  event.car = 0;
+  event.floor = 0;
+  if (event.kind == TraceEvent::Kind::Step) {
+    return true;
+  }
+
+  uint64_t car = 0;
+  uint64_t floor = 0;
+  if (!readVarint(car) || !readVarint(floor) ||
+      car > std::numeric_limits<uint32_t>::max()) {
+    valid_ = false;
+    return std::unexpected(malformed());
+  }
+  const int64_t value = unzigzag(floor);
+  if (value < std::numeric_limits<int>::min() ||
+      value > std::numeric_limits<int>::max()) {
+    valid_ = false;
+    return std::unexpected(malformed());
+  }
+  event.car = static_cast<uint32_t>(car);
+  event.floor = static_cast<int>(value);
+  return true;
+}
+
+bool TraceDecoder::readVarint(uint64_t& value) noexcept {
+  value = 0;
+  for (int i = 0; i < kMaxVarintBytes && position_ != end_; ++i) {
+    const auto byte = static_cast<uint64_t>(*position_++);
+    value |= (byte & 0x7F) << (7 * i);
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;  // Truncated or longer than a uint64_t.
+}
+
+}  // namespace elevator
@@ -0,0 +1,7 @@
+#include "../include/traffic_study.hpp"
+
+namespace elevator {
+
+template class BasicTrafficStudy<1, 9>;
+
+}  // namespace elevator
@@ -10,15 +10,28 @@
 #include <algorithm>
 #include <chrono>
 #include <condition_variable>
+#include <coroutine>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
 #include <functional>
 #include <limits>
+#include <memory>
+#include <memory_resource>
 #include <mutex>
+#include <optional>
 #include <span>
+#include <system_error>
 #include <iterator>
 #include <utility>
 #include <vector>
 
+#include "byte_ring.hpp"
+#include "crc32c.hpp"
+#include "mapped_file.hpp"
+#include "stream_metrics.hpp"
+
 /**
  * @class ByteStreamController
  * @brief A thread-safe controller for byte stream operations with configurable
@@ -29,13 +42,21 @@
  * handling.
  */
 class ByteStreamController {
+ private:
+  struct ProducerSlab;  // Per-producer staging area, see Backend::Sharded
+
  public:
   using Byte = std::byte;  ///< Type alias for byte
   using ByteSpan =
       std::span<const Byte>;          ///< Type alias for read-only byte span
   using ByteVec = std::vector<Byte>;  ///< Type alias for byte vector
+  using PooledByteVec =
+      std::pmr::vector<Byte>;  ///< Byte vector on a memory resource
   using Callback =
       std::function<void(ByteSpan)>;  ///< Type alias for callback function
+  using MetricsSnapshot =
+      StreamMetrics::Snapshot;  ///< Type alias for metrics snapshot
+  using DropReason = StreamMetrics::DropReason;  ///< Type alias for reason
 
   /// Default buffer size (4096 bytes)
   static constexpr size_t DEFAULT_BUFFER_SIZE = 4096;
@@ -51,6 +72,9 @@ class ByteStreamController {
   static constexpr std::chrono::milliseconds DEFAULT_DEVICE_DELAY{100};
   /// Default read timeout (1000ms)
   static constexpr std::chrono::milliseconds DEFAULT_READ_TIMEOUT{1000};
+  /// Default time a producer waits for space under OverflowPolicy::Block
+  /// (1000ms)
+  static constexpr std::chrono::milliseconds DEFAULT_BLOCK_TIMEOUT{1000};
 
   /**
    * @enum ErrorCode
@@ -64,6 +88,95 @@ class ByteStreamController {
     InvalidArgs         ///< Operation has invalid args    
   };
 
+  /**
+   * @enum Backend
+   * @brief Storage and synchronization strategy of the controller
+   */
+  enum class Backend : uint8_t {
+    Mutex,   ///< Any number of producers and readers, one shared mutex
+    Spsc,    ///< One producer and one reader, lock-free data path
+    Sharded  ///< Registered producers write lock-free into private slabs
+  };
+
+  /**
+   * @enum BatchPolicy
+   * @brief What a vectored add does when the parts do not all fit
+   */
+  enum class BatchPolicy : uint8_t {
+    AllOrNothing,  ///< Reject the whole batch
+    Partial        ///< Accept the longest prefix that fits
+  };
+
+  /**
+   * @enum OverflowPolicy
+   * @brief What a producer does when its data does not fit in the buffer
+   *
+   * Bytes discarded by DropOldest and DropNewest, and bytes lost by the
+   * get_callback() producer, are reported in Result::dropped_bytes.
+   */
+  enum class OverflowPolicy : uint8_t {
+    Reject,      ///< Fail with BufferOverflow, buffer unchanged
+    DropOldest,  ///< Evict the oldest unread bytes to make room
+    DropNewest,  ///< Keep the part of the new data that fits, drop the rest
+    Block        ///< Wait up to block_timeout for space, then reject
+  };
+
+  /**
+   * @struct WaitStrategy
+   * @brief How a reader waits for data before sleeping
+   *
+   * A waiting reader first polls spin_count times with a CPU pause hint,
+   * then yield_count times with std::this_thread::yield(), and only then
+   * blocks on the condition variable for the read timeout. The default
+   * blocks right away. Backend::Sharded readers always block right away
+   * because staged data can only be inspected under the mutex.
+   */
+  struct WaitStrategy {
+    uint32_t spin_count = 0;   ///< Busy-wait iterations before yielding
+    uint32_t yield_count = 0;  ///< Yield iterations before blocking
+  };
+
+  /**
+   * @struct Options
+   * @brief Construction parameters of the controller
+   */
+  struct Options {
+    size_t max_buffer_size = DEFAULT_BUFFER_SIZE;  ///< Buffer capacity
+    Backend backend = Backend::Mutex;              ///< Storage backend
+    /// Behaviour when data does not fit. With Backend::Spsc, DropOldest
+    /// truncates the new data instead because the producer cannot evict.
+    OverflowPolicy overflow_policy = OverflowPolicy::Reject;
+    /// Producer wait bound for OverflowPolicy::Block
+    std::chrono::milliseconds block_timeout = DEFAULT_BLOCK_TIMEOUT;
+    /// Staging capacity of every registered producer (Backend::Sharded)
+    size_t producer_slab_size = DEFAULT_BUFFER_SIZE;
+    /// Report which producer wrote which bytes (Backend::Sharded)
+    bool tag_producers = false;
+    /// Spin and yield budgets of waiting readers
+    WaitStrategy wait_strategy{};
+    /// Treat every add or commit as one message that readers never receive
+    /// torn (Backend::Mutex)
+    bool framed = false;
+    /// Scratch file that absorbs data once the buffer is full
+    /// (Backend::Mutex); empty disables spilling
+    std::filesystem::path spill_path{};
+    /// Capacity of the spill file in bytes; 0 disables spilling
+    size_t spill_capacity = 0;
+    /// Own a memory pool for PooledByteVec reads, see result_resource()
+    bool pool_results = false;
+    /// Compute the CRC32C of copied-out data in the same pass as the copy
+    bool checksum = false;
+  };
+
+  /**
+   * @struct ProducerChunk
+   * @brief Run of consecutive bytes written by one producer
+   */
+  struct ProducerChunk {
+    uint32_t producer_id = 0;  ///< Producer::id(), 0 for async_add_data()
+    size_t size = 0;           ///< Length of the run in bytes
+  };
+
   /**
    * @struct Result
    * @brief Result of synchronous data retrieval operation
@@ -71,8 +184,119 @@ class ByteStreamController {
   struct Result {
     ByteVec data;                          ///< Retrieved data
     ErrorCode error = ErrorCode::NoError;  ///< Error code
-    size_t dropped_bytes = 0;              ///< Number of dropped bytes (if any)
+    size_t dropped_bytes = 0;  ///< Bytes dropped since the previous read
+    size_t buffer_size = 0;  ///< Current buffer size at time of operation
+    std::vector<ProducerChunk> chunks;  ///< Origin of data (tag_producers)
+    uint32_t crc32c = 0;  ///< CRC32C of data (Options::checksum)
+
+    /**
+     * @brief Conversion to bool indicating success
+     * @return true if no error occurred, false otherwise
+     */
+    explicit operator bool() const { return error == ErrorCode::NoError; }
+  };
+
+  /**
+   * @struct AddResult
+   * @brief Result of a vectored data addition
+   */
+  struct AddResult {
+    ErrorCode error = ErrorCode::NoError;  ///< Error code
+    size_t accepted_bytes = 0;             ///< Bytes appended to the buffer
+
+    /**
+     * @brief Conversion to bool indicating success
+     * @return true if no error occurred, false otherwise
+     */
+    explicit operator bool() const { return error == ErrorCode::NoError; }
+  };
+
+  /**
+   * @struct DrainResult
+   * @brief Result of close_and_drain()
+   */
+  struct DrainResult {
+    ErrorCode error = ErrorCode::NoError;  ///< Error code
+    size_t flushed_bytes = 0;    ///< Buffered bytes readers took after closing
+    size_t discarded_bytes = 0;  ///< Bytes still buffered at the deadline
+
+    /**
+     * @brief Conversion to bool indicating success
+     * @return true if no error occurred, false otherwise
+     */
+    explicit operator bool() const { return error == ErrorCode::NoError; }
+  };
+
+  /**
+   * @struct CopyResult
+   * @brief Result of a read into a caller-supplied buffer
+   */
+  struct CopyResult {
+    size_t size = 0;                       ///< Bytes written to the buffer
+    ErrorCode error = ErrorCode::NoError;  ///< Error code
+    size_t dropped_bytes = 0;  ///< Bytes dropped since the previous read
+    size_t buffer_size = 0;  ///< Current buffer size at time of operation
+    uint32_t crc32c = 0;  ///< CRC32C of the bytes written (Options::checksum)
+
+    /**
+     * @brief Conversion to bool indicating success
+     * @return true if no error occurred, false otherwise
+     */
+    explicit operator bool() const { return error == ErrorCode::NoError; }
+  };
+
+  /**
+   * @struct ReadView
+   * @brief Borrowed view of buffered data returned by read_view()
+   *
+   * The regions point directly into the controller's storage and stay valid
+   * until consume() is called. Producers cannot overwrite them before that.
+   */
+  struct ReadView {
+    ByteSpan first;   ///< Oldest contiguous region
+    ByteSpan second;  ///< Wrapped-around remainder (empty if contiguous)
+    ErrorCode error = ErrorCode::NoError;  ///< Error code
+    size_t dropped_bytes = 0;  ///< Bytes dropped since the previous read
+    size_t buffer_size = 0;  ///< Bytes left in the buffer besides the view
+    std::vector<ProducerChunk> chunks;  ///< Origin of data (tag_producers)
+
+    /// @return Total number of bytes in the view
+    [[nodiscard]] size_t size() const noexcept {
+      return first.size() + second.size();
+    }
+
+    /**
+     * @brief Conversion to bool indicating success
+     * @return true if no error occurred, false otherwise
+     */
+    explicit operator bool() const { return error == ErrorCode::NoError; }
+  };
+
+  /**
+   * @struct MessageBatch
+   * @brief Whole messages returned by read_messages()
+   */
+  struct MessageBatch {
+    ByteVec data;                          ///< Messages back to back
+    std::vector<size_t> ends;              ///< End offset of each message
+    ErrorCode error = ErrorCode::NoError;  ///< Error code
+    size_t dropped_bytes = 0;  ///< Bytes dropped since the previous read
     size_t buffer_size = 0;  ///< Current buffer size at time of operation
+    /// CRC32C of each message (Options::checksum)
+    std::vector<uint32_t> crc32c{};
+
+    /// @return Number of messages in the batch
+    [[nodiscard]] size_t count() const noexcept { return ends.size(); }
+
+    /**
+     * @brief Access one message
+     * @param index Message index below count()
+     * @return Bytes of the message inside data
+     */
+    [[nodiscard]] ByteSpan message(size_t index) const noexcept {
+      const size_t begin = index == 0 ? 0 : ends[index - 1];
+      return ByteSpan(data).subspan(begin, ends[index] - begin);
+    }
 
     /**
      * @brief Conversion to bool indicating success
@@ -81,6 +305,91 @@ class ByteStreamController {
     explicit operator bool() const { return error == ErrorCode::NoError; }
   };
 
+  /**
+   * @class Producer
+   * @brief Handle through which one producer thread adds data
+   *
+   * With Backend::Sharded every handle owns a staging slab that its thread
+   * fills without touching the controller mutex; readers merge the slabs in
+   * order. With the other backends the handle forwards to async_add_data().
+   * A handle is used by one thread at a time and must not outlive the
+   * controller. Data staged before the handle is destroyed is still
+   * delivered.
+   */
+  class Producer {
+   public:
+    Producer(Producer&& other) noexcept;
+    Producer& operator=(Producer&& other) noexcept;
+    Producer(const Producer&) = delete;
+    Producer& operator=(const Producer&) = delete;
+    ~Producer();
+
+    /**
+     * @brief Add data, with the semantics of async_add_data()
+     * @param data Span of bytes to add
+     * @return ErrorCode indicating success or failure
+     *
+     * Under Backend::Sharded the overflow policy applies to the slab, and
+     * DropOldest truncates the new data as with Backend::Spsc.
+     */
+    ErrorCode add_data(ByteSpan data);
+
+    /// @return Id reported in ProducerChunk::producer_id
+    [[nodiscard]] uint32_t id() const noexcept { return id_; }
+
+   private:
+    friend class ByteStreamController;
+
+    Producer(ByteStreamController* controller, ProducerSlab* slab,
+             uint32_t id) noexcept;
+
+    ByteStreamController* controller_;  ///< Owning controller
+    ProducerSlab* slab_;                ///< Staging slab (Sharded only)
+    uint32_t id_;                       ///< Producer id, starting at 1
+  };
+
+  /**
+   * @class ReadAwaitable
+   * @brief Awaitable returned by async_get_data()
+   *
+   * Suspends the awaiting coroutine until @c min_bytes are buffered or the
+   * controller stops, then yields the same Result as sync_get_data(). The
+   * coroutine is resumed on the thread whose add, commit, consume or stop
+   * made the data available, or inside process_async_timeouts() once the
+   * deadline has passed. A suspended coroutine must not be destroyed before
+   * it has been resumed, and the awaitable must be awaited at most once.
+   */
+  class ReadAwaitable {
+   public:
+    /// @return true if the read can complete without suspending
+    [[nodiscard]] bool await_ready() const;
+
+    /**
+     * @brief Register the coroutine with the controller
+     * @param handle Coroutine to resume once the read can complete
+     * @return false if data arrived while registering (no suspension)
+     */
+    bool await_suspend(std::coroutine_handle<> handle);
+
+    /// @return Result of the read
+    Result await_resume();
+
+   private:
+    friend class ByteStreamController;
+
+    ReadAwaitable(ByteStreamController* controller, size_t min_bytes,
+                  size_t max_bytes,
+                  std::chrono::steady_clock::time_point deadline) noexcept;
+
+    ByteStreamController* controller_;  ///< Controller to read from
+    size_t min_bytes_;                  ///< Bytes needed to complete
+    size_t max_bytes_;                  ///< Upper bound on bytes read
+    std::chrono::steady_clock::time_point deadline_;  ///< Timeout point
+    std::coroutine_handle<> handle_;    ///< Suspended coroutine
+    Result result_{};                   ///< Filled in before resumption
+    bool completed_ = false;            ///< result_ is valid
+  };
+
   /**
    * @brief Construct a new ByteStreamController object
    * @param max_buffer_size Maximum buffer size in bytes (default:
@@ -88,6 +397,40 @@ class ByteStreamController {
    */
   explicit ByteStreamController(size_t max_buffer_size = DEFAULT_BUFFER_SIZE);
 
+  /**
+   * @brief Construct a new ByteStreamController object
+   * @param options Buffer size and backend selection
+   *
+   * With Backend::Spsc exactly one thread may add data and exactly one thread
+   * may read it. The data path then takes no lock; the mutex and condition
+   * variable are only touched when the reader has to sleep.
+   *
+   * With Backend::Sharded producers obtained from register_producer() never
+   * contend with each other; readers merge their slabs under the mutex.
+   *
+   * With Options::framed (Backend::Mutex only) every async_add_data() call,
+   * vectored batch or commit() is one message. Messages are accepted or
+   * dropped whole, DropOldest evicts whole messages, and reads and consume()
+   * stop at message boundaries.
+   *
+   * With Options::pool_results the controller owns a synchronized pool
+   * sized for the buffer; PooledByteVec reads allocated from
+   * result_resource() take their storage from it and give it back when
+   * destroyed, so steady-state reads do not call malloc.
+   *
+   * With Options::checksum every read that copies data out also computes
+   * its CRC32C while copying, one message at a time for read_messages().
+   * Data borrowed with read_view() can be checked with crc32c_extend().
+   *
+   * With Options::spill_path and Options::spill_capacity (Backend::Mutex
+   * only) data that does not fit into the in-memory buffer goes to a
+   * memory-mapped spill file, and readers drain it transparently in order.
+   * The overflow policy then applies once the spill file is full too, and
+   * DropOldest truncates the new data like with Backend::Spsc. If the file
+   * cannot be created the controller runs without it, see spill_error().
+   */
+  explicit ByteStreamController(const Options& options);
+
   /**
    * @brief Destroy the ByteStreamController object
    * Stops the controller and cleans up resources
@@ -110,17 +453,89 @@ class ByteStreamController {
   /**
    * @brief Start the controller
    *
-   * Resets the controller to operational state
+   * Resets the controller to operational state, also after
+   * close_and_drain()
    */
   void start();
 
+  /**
+   * @brief Fence off producers, let readers drain the buffer, then stop
+   * @param deadline Point in time after which remaining data is discarded
+   * @return DrainResult with the bytes readers received and the bytes
+   * discarded. The error is ErrorCode::Timeout if anything was discarded
+   * and ErrorCode::ControllerStopped if the controller was already stopped
+   * or closing.
+   *
+   * New adds and reservations fail with ErrorCode::ControllerStopped from
+   * the moment of the call; adds already under way and open reservations
+   * may complete until the deadline. Readers then stop waiting for
+   * min_bytes: every read returns what is buffered, up to max_bytes in one
+   * batch, with ErrorCode::NoError, and ErrorCode::ControllerStopped once
+   * the buffer is empty. The call blocks until the buffer is empty or the
+   * deadline has passed, so it must not be made from a reader thread, and
+   * leaves the controller stopped.
+   *
+   * With Backend::Spsc the reader owns the consuming end of the ring, so
+   * bytes left at the deadline are not removed: they are counted as
+   * discarded, and later reads return them with ErrorCode::ControllerStopped.
+   */
+  DrainResult close_and_drain(std::chrono::steady_clock::time_point deadline);
+
   /**
    * @brief Asynchronously add data to the buffer
    * @param data Span of bytes to add
    * @return ErrorCode indicating success or failure
+   *
+   * When the data does not fit, the configured OverflowPolicy applies.
+   * Dropping policies still return ErrorCode::NoError.
    */
    ErrorCode async_add_data(ByteSpan data);
 
+  /**
+   * @brief Asynchronously add several spans as one contiguous batch
+   * @param parts Spans appended back to back, e.g. header, payload, trailer
+   * @param policy Behaviour when the batch exceeds the free space
+   * @return AddResult with the number of bytes accepted; the error is
+   * ErrorCode::BufferOverflow whenever part of the batch was not accepted
+   *
+   * The batch is appended under a single lock with a single reader wakeup,
+   * so data from other producers never lands between the parts.
+   * DropOldest and Block make room as for a single span; whatever still
+   * does not fit is handled by @p policy.
+   */
+  AddResult async_add_data(std::span<const ByteSpan> parts,
+                           BatchPolicy policy = BatchPolicy::AllOrNothing);
+
+  /**
+   * @brief Register a producer thread
+   * @return Handle for adding data (see Producer)
+   */
+  Producer register_producer();
+
+  /**
+   * @brief Reserve space to write data in place
+   * @param bytes Number of bytes the producer wants to write
+   * @return Writable span of exactly @p bytes, or an empty span if the
+   * controller is stopped, @p bytes is zero or the data would not fit
+   *
+   * The span usually points straight into the controller's storage; when the
+   * free space wraps around, a scratch block is returned and copied in by
+   * commit(). A successful reserve must be followed by commit() from the
+   * same thread; with the Mutex backend other producers wait until then,
+   * and with Backend::Sharded readers merge no slab data until then.
+   */
+  std::span<Byte> reserve(size_t bytes);
+
+  /**
+   * @brief Publish data written into the last reserve() span
+   * @param bytes Number of leading bytes to publish (0 abandons the
+   * reservation)
+   * @return ErrorCode::InvalidArgs, with nothing published and an open
+   * reservation left open, if no reservation is open or @p bytes exceeds
+   * it; ErrorCode::NoError otherwise
+   */
+  ErrorCode commit(size_t bytes);
+
   /**
    * @brief Synchronously get data from the buffer
    * @param min_bytes Minimum number of bytes to retrieve (default:
@@ -135,18 +550,174 @@ class ByteStreamController {
       size_t max_bytes = std::numeric_limits<size_t>::max(),
       std::chrono::milliseconds timeout = DEFAULT_READ_TIMEOUT);
 
+  /**
+   * @brief Read data from a coroutine without blocking a thread
+   * @param min_bytes Minimum number of bytes to retrieve (default:
+   * MIN_READ_SIZE)
+   * @param max_bytes Maximum number of bytes to retrieve (default: unlimited)
+   * @param timeout Maximum time to wait for data (default:
+   * DEFAULT_READ_TIMEOUT), enforced by process_async_timeouts()
+   * @return Awaitable yielding a Result, see ReadAwaitable
+   *
+   * With Backend::Spsc the awaiting coroutine counts as the only reader.
+   */
+  [[nodiscard]] ReadAwaitable async_get_data(
+      size_t min_bytes = MIN_READ_SIZE,
+      size_t max_bytes = std::numeric_limits<size_t>::max(),
+      std::chrono::milliseconds timeout = DEFAULT_READ_TIMEOUT);
+
+  /**
+   * @brief Complete suspended async_get_data() reads whose timeout expired
+   * @param now Point in time to compare the deadlines against
+   * @return Number of coroutines resumed with ErrorCode::Timeout
+   *
+   * The controller has no timer thread; an event loop calls this
+   * periodically. Resumption happens on the calling thread.
+   */
+  size_t process_async_timeouts(
+      std::chrono::steady_clock::time_point now =
+          std::chrono::steady_clock::now());
+
+  /**
+   * @brief Synchronously read into a caller-supplied buffer
+   * @param out Destination; its size is the maximum number of bytes read
+   * @param min_bytes Minimum number of bytes to retrieve (default:
+   * MIN_READ_SIZE)
+   * @param timeout Maximum time to wait for data (default:
+   * DEFAULT_READ_TIMEOUT)
+   * @return CopyResult with the number of bytes written to @p out
+   *
+   * Nothing is allocated; producer tags are not reported.
+   */
+  CopyResult sync_get_data(
+      std::span<Byte> out, size_t min_bytes = MIN_READ_SIZE,
+      std::chrono::milliseconds timeout = DEFAULT_READ_TIMEOUT);
+
+  /**
+   * @brief Synchronously read into a reused vector
+   * @param out Replaced by the data; its capacity is reused
+   * @param min_bytes Minimum number of bytes to retrieve (default:
+   * MIN_READ_SIZE)
+   * @param max_bytes Maximum number of bytes to retrieve (default: unlimited)
+   * @param timeout Maximum time to wait for data (default:
+   * DEFAULT_READ_TIMEOUT)
+   * @return CopyResult with the new size of @p out
+   */
+  CopyResult sync_get_data(
+      ByteVec& out, size_t min_bytes = MIN_READ_SIZE,
+      size_t max_bytes = std::numeric_limits<size_t>::max(),
+      std::chrono::milliseconds timeout = DEFAULT_READ_TIMEOUT);
+
+  /**
+   * @brief Synchronously read into a reused vector on a memory resource
+   * @param out Replaced by the data; storage comes from its allocator, e.g.
+   * result_resource()
+   * @param min_bytes Minimum number of bytes to retrieve (default:
+   * MIN_READ_SIZE)
+   * @param max_bytes Maximum number of bytes to retrieve (default: unlimited)
+   * @param timeout Maximum time to wait for data (default:
+   * DEFAULT_READ_TIMEOUT)
+   * @return CopyResult with the new size of @p out
+   */
+  CopyResult sync_get_data(
+      PooledByteVec& out, size_t min_bytes = MIN_READ_SIZE,
+      size_t max_bytes = std::numeric_limits<size_t>::max(),
+      std::chrono::milliseconds timeout = DEFAULT_READ_TIMEOUT);
+
+  /**
+   * @brief Get the memory resource for pooled reads
+   * @return The pool of Options::pool_results, which must outlive every
+   * vector allocated from it, or the default resource without the option
+   */
+  [[nodiscard]] std::pmr::memory_resource* result_resource() const noexcept;
+
+  /**
+   * @brief Borrow buffered data without copying it
+   * @param min_bytes Minimum number of bytes to wait for (default:
+   * MIN_READ_SIZE)
+   * @param max_bytes Maximum number of bytes in the view (default: unlimited)
+   * @param timeout Maximum time to wait for data (default:
+   * DEFAULT_READ_TIMEOUT)
+   * @return ReadView over at most @p max_bytes of the oldest data
+   *
+   * Every non-empty view must be released with consume(), possibly
+   * consume(0). Until then other readers wait and the viewed bytes are not
+   * reused by producers.
+   *
+   * In framed mode the view ends on a message boundary; if the oldest
+   * message alone exceeds @p max_bytes the error is ErrorCode::InvalidArgs.
+   */
+  ReadView read_view(size_t min_bytes = MIN_READ_SIZE,
+                     size_t max_bytes = std::numeric_limits<size_t>::max(),
+                     std::chrono::milliseconds timeout = DEFAULT_READ_TIMEOUT);
+
+  /**
+   * @brief Release data borrowed with read_view()
+   * @param bytes Number of leading bytes of the view to drop from the buffer;
+   * the rest stays buffered for the next read. In framed mode this is
+   * rounded down to whole messages.
+   */
+  void consume(size_t bytes);
+
+  /**
+   * @brief Read whole messages (framed mode)
+   * @param max_messages Maximum number of messages to retrieve
+   * @param max_bytes Maximum total size of the messages (default: unlimited)
+   * @param timeout Maximum time to wait for a message (default:
+   * DEFAULT_READ_TIMEOUT)
+   * @return MessageBatch with at least one message on success;
+   * ErrorCode::InvalidArgs without framed mode, for zero @p max_messages
+   * or if the oldest message alone exceeds @p max_bytes
+   *
+   * The batch is copied out with one pass over the buffer; message
+   * boundaries come from the index kept by the producers.
+   */
+  MessageBatch read_messages(
+      size_t max_messages,
+      size_t max_bytes = std::numeric_limits<size_t>::max(),
+      std::chrono::milliseconds timeout = DEFAULT_READ_TIMEOUT);
+
   /**
    * @brief Get current buffer size
    * @return Current number of bytes in buffer
    */
   size_t current_buffer_size() const;
 
+  /**
+   * @brief Get the number of bytes waiting in the spill file
+   * @return Spilled bytes, 0 without a spill file
+   */
+  size_t spilled_bytes() const;
+
+  /**
+   * @brief Get the reason the spill file is missing
+   * @return Error from creating the spill file, empty if it was created or
+   * not requested
+   */
+  std::error_code spill_error() const noexcept { return spill_error_; }
+
   /**
    * @brief Check if controller is stopped
    * @return true if controller is stopped, false otherwise
    */
   bool is_stopped() const;
 
+  /**
+   * @brief Get the backend selected at construction
+   * @return Backend in use
+   */
+  Backend backend() const noexcept { return backend_; }
+
+  /**
+   * @brief Read the runtime counters without taking the mutex
+   * @return Bytes in and out, drops by reason, read timeouts, the buffer
+   * high-water mark and the histogram of read wait times
+   *
+   * Counters are relaxed atomics spread over per-thread cache lines, so
+   * scraping them does not slow producers or readers down.
+   */
+  MetricsSnapshot metrics() const noexcept;
+
   /**
    * @brief Get a callback for asynchronous data addition
    * @return Callback function that can be used to add data
@@ -156,7 +727,188 @@ class ByteStreamController {
  private:
   mutable std::mutex mutex_;      ///< Mutex for thread safety
   std::condition_variable cv_;    ///< Condition variable for synchronization
-  ByteVec buffer_;                ///< Internal data buffer
+  std::condition_variable producer_cv_;  ///< Producers waiting on a reserve
   const size_t max_buffer_size_;  ///< Maximum buffer capacity
+  const Backend backend_;         ///< Selected backend
+  const OverflowPolicy overflow_policy_;         ///< Full-buffer behaviour
+  const std::chrono::milliseconds block_timeout_;  ///< Block policy bound
+  const WaitStrategy wait_strategy_;  ///< Reader spin/yield budgets
   std::atomic<bool> stopped_;     ///< Atomic flag indicating stopped state
+  std::atomic<bool> closed_{false};    ///< Producers are fenced off
+  std::atomic<bool> draining_{false};  ///< Readers take what is left
+  std::atomic<bool> spsc_writing_{false};  ///< Spsc add or reservation open
+  ByteRing ring_;                 ///< Circular data storage
+  std::atomic<size_t> sleeping_readers_{0};  ///< Readers parked on cv_
+  std::atomic<size_t> blocked_producers_{0};  ///< Producers waiting for space
+  std::atomic<size_t> dropped_bytes_{0};  ///< Drops not yet reported
+  StreamMetrics metrics_;                 ///< Runtime counters
+  std::vector<ReadAwaitable*> async_waiters_;  ///< Suspended coroutines
+  std::atomic<size_t> async_waiter_count_{0};  ///< Size of async_waiters_
+  bool view_open_ = false;  ///< A ReadView is outstanding (Mutex backend)
+  size_t reserved_bytes_ = 0;         ///< Size of the open reservation
+  bool reserved_in_staging_ = false;  ///< Open reservation uses staging_
+  ByteVec staging_;                   ///< Scratch for wrapping reservations
+  const bool checksum_;               ///< Checksum copied-out data
+  /// Storage of PooledByteVec reads (Options::pool_results)
+  std::unique_ptr<std::pmr::synchronized_pool_resource> result_pool_;
+  const size_t producer_slab_size_;   ///< Capacity of new slabs
+  const bool tag_producers_;          ///< Maintain tags_ (Sharded only)
+  uint32_t last_producer_id_ = 0;     ///< Last id handed out
+  std::vector<std::unique_ptr<ProducerSlab>> slabs_;  ///< Producer slabs
+  size_t merge_cursor_ = 0;           ///< Slab merged first next time
+  /// Bytes staged in slabs for the high-water mark; producers count their
+  /// bytes after staging them, so the value can briefly be negative
+  std::atomic<int64_t> staged_bytes_{0};
+  std::deque<ProducerChunk> tags_;    ///< Origin of the bytes in ring_
+  size_t tagged_bytes_ = 0;           ///< Bytes covered by tags_
+  const bool framed_;                 ///< Message-framed mode (Mutex only)
+  std::deque<size_t> frames_;         ///< Sizes of the buffered messages
+  std::optional<MappedFile> spill_file_;  ///< Storage of spill_
+  std::unique_ptr<ByteRing> spill_;   ///< Data queued behind ring_
+  std::error_code spill_error_;       ///< Why spill_ is missing
+  ByteRing* reserved_ring_ = nullptr;  ///< Ring of the open reservation
+
+  // Lock-free add into a ring with a single producer (Spsc backend and
+  // Sharded slabs).
+  ErrorCode push_lock_free(ByteRing& ring, ByteSpan data);
+
+  // False once stop() or close_and_drain() fenced off producers.
+  [[nodiscard]] bool accepting() const noexcept;
+
+  // True once waiting readers must return without min_bytes (stop() or
+  // the drain phase of close_and_drain()).
+  [[nodiscard]] bool readers_released() const noexcept;
+
+  // Marks a lock-free add or reservation as under way, so that
+  // close_and_drain() waits for it. Returns false, with the mark cleared,
+  // if producers are fenced off.
+  bool begin_lock_free_write(std::atomic<bool>& writing);
+  void end_lock_free_write(std::atomic<bool>& writing);
+
+  // True while an add or reservation that passed the fence is under way
+  // (lock held).
+  [[nodiscard]] bool writes_in_flight() const;
+
+  // Drops everything buffered and returns its size (lock held, not Spsc).
+  size_t discard_buffered();
+
+  // Wakes a reader parked in spsc_wait, if there is one.
+  void wake_reader();
+
+  // True if a reader is parked on cv_ (exact with the lock held).
+  [[nodiscard]] bool has_sleeping_readers() const noexcept;
+
+  // True if a coroutine is suspended in async_get_data.
+  [[nodiscard]] bool has_async_waiters() const noexcept;
+
+  // Resumes suspended coroutines whose read can now complete (no lock held).
+  void resume_async_waiters();
+
+  // Wakes producers parked in spsc_wait_space, if there are any.
+  void wake_producers();
+
+  // Waits up to block_timeout_ for the given free space in a lock-free
+  // ring. Returns false if the controller stopped or the size can never fit.
+  bool spsc_wait_space(const ByteRing& ring, size_t bytes);
+
+  // Waits until no reservation is open and, under OverflowPolicy::Block,
+  // until the given size fits (Mutex backend, lock held). Returns false if
+  // the controller stopped meanwhile.
+  bool wait_producer_turn(std::unique_lock<std::mutex>& lock, size_t bytes);
+
+  // Evicts old data for the given size under OverflowPolicy::DropOldest
+  // (Mutex backend, lock held).
+  void make_room(size_t bytes);
+
+  // True if a full buffer keeps the prefix of new data that still fits.
+  [[nodiscard]] bool truncates_on_overflow() const noexcept;
+
+  // Appends the part of data that fits, records the rest as dropped and
+  // returns the size of the part.
+  size_t push_prefix(ByteRing& ring, ByteSpan data);
+
+  // Reason counted for data refused under the configured overflow policy.
+  [[nodiscard]] DropReason rejection_reason() const noexcept;
+
+  // Counts a read_view call that started waiting at wait_start.
+  void record_read(std::chrono::steady_clock::time_point wait_start,
+                   bool ready) noexcept;
+
+  // Adds to the drop count reported by the next read.
+  void record_drop(size_t bytes) noexcept;
+
+  // Copies as much of the batch as the policy allows into the ring.
+  AddResult push_parts(std::span<const ByteSpan> parts, size_t total,
+                       BatchPolicy policy);
+
+  // Opens a reservation of the given size, or returns an empty span.
+  std::span<Byte> reserve_region(size_t bytes);
+
+  // True if a reservation is open and holds at least the given size.
+  [[nodiscard]] bool fits_reservation(size_t bytes) const noexcept;
+
+  // Closes the open reservation, publishing its first bytes.
+  void publish_reserved(size_t bytes);
+
+  // Waits without the mutex until min_bytes are buffered or the controller
+  // stops (Spsc backend). Returns false on timeout.
+  bool spsc_wait(size_t min_bytes, std::chrono::milliseconds timeout);
+
+  // Polls within the wait strategy (Mutex backend), takes the deferred lock
+  // and waits until min_bytes are readable or the controller stops.
+  // Returns false on timeout.
+  bool wait_readable(std::unique_lock<std::mutex>& lock, size_t min_bytes,
+                     std::chrono::milliseconds timeout);
+
+  // Records a new message of the given size in framed mode.
+  void push_frame(size_t bytes);
+
+  // Size of the leading whole messages within both limits (framed mode).
+  [[nodiscard]] size_t frame_prefix(size_t max_messages,
+                                    size_t max_bytes) const;
+
+  // Forgets the whole messages within the given leading bytes and returns
+  // their total size.
+  size_t pop_frames(size_t bytes);
+
+  // Copies the view to dst and returns its CRC32C (0 without checksum_).
+  uint32_t copy_view(const ReadView& view, Byte* dst) const;
+
+  // Reads into a vector of either allocator, reusing its capacity.
+  template <typename Vec>
+  CopyResult read_into(Vec& out, size_t min_bytes, size_t max_bytes,
+                       std::chrono::milliseconds timeout);
+
+  // Builds a view over up to max_bytes of the oldest data.
+  ReadView make_view(size_t max_bytes, bool stopped);
+
+  // Bytes in ring_ plus bytes staged in slabs (lock held).
+  [[nodiscard]] size_t buffered_locked() const;
+
+  // True while a reservation is open in ring_, which must not be written
+  // until the commit (lock held). Always false with Backend::Spsc.
+  [[nodiscard]] bool ring_reserved() const noexcept;
+
+  // Bytes a reader can take now: buffered_locked(), minus slab and spill
+  // data that cannot be moved into ring_ during a reservation (lock held).
+  [[nodiscard]] size_t readable_locked() const;
+
+  // Ring that new data of the given size goes to: ring_, or the spill file
+  // once it is in use (lock held with a spill file).
+  ByteRing& write_ring(size_t bytes);
+
+  // Largest add that can ever be accepted.
+  [[nodiscard]] size_t max_write_size() const noexcept;
+
+  // Moves spilled data into ring_ as space allows (lock held).
+  void refill_from_spill();
+
+  // Moves staged slab data into ring_ as space allows (lock held).
+  void merge_slabs();
+
+  // Tag bookkeeping for tag_producers_ (lock held).
+  void tag_bytes(uint32_t producer_id, size_t bytes);
+  void tag_untagged();
+  void pop_tags(size_t bytes);
+  [[nodiscard]] std::vector<ProducerChunk> collect_tags(size_t bytes) const;
 };
\ No newline at end of file
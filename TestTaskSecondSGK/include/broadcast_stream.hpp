@@ -0,0 +1,236 @@
+/**
+ * @file broadcast_stream.hpp
+ * @brief A byte stream delivered in full to every subscribed consumer.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "async_controller.hpp"
+
+/**
+ * @class BroadcastStream
+ * @brief Fan-out stream with one shared buffer and a read cursor per consumer
+ *
+ * Every byte added is stored once and read by each consumer obtained from
+ * subscribe() at its own pace. A byte is reclaimed as soon as the slowest
+ * consumer has read it. A consumer sees only data added after it
+ * subscribed; data added while nobody is subscribed is discarded.
+ *
+ * How far a consumer may fall behind the newest data is bounded by
+ * Options::max_lag; the LagPolicy decides whether producers then wait for
+ * it or whether it loses its oldest unread bytes.
+ */
+class BroadcastStream {
+ private:
+  struct Cursor;  // Read position of one consumer
+
+ public:
+  using Byte = ByteStreamController::Byte;  ///< Type alias for byte
+  using ByteSpan =
+      ByteStreamController::ByteSpan;  ///< Type alias for read-only byte span
+  using ErrorCode =
+      ByteStreamController::ErrorCode;  ///< Type alias for error code
+  using Result =
+      ByteStreamController::Result;  ///< Type alias for read result
+
+  /// Default buffer size (4096 bytes)
+  static constexpr size_t DEFAULT_BUFFER_SIZE =
+      ByteStreamController::DEFAULT_BUFFER_SIZE;
+  /// Default read timeout (1000ms)
+  static constexpr std::chrono::milliseconds DEFAULT_READ_TIMEOUT =
+      ByteStreamController::DEFAULT_READ_TIMEOUT;
+  /// Default time a producer waits for a slow consumer under
+  /// LagPolicy::Block (1000ms)
+  static constexpr std::chrono::milliseconds DEFAULT_BLOCK_TIMEOUT =
+      ByteStreamController::DEFAULT_BLOCK_TIMEOUT;
+
+  /**
+   * @enum LagPolicy
+   * @brief What happens to a consumer that would fall behind max_lag
+   */
+  enum class LagPolicy : uint8_t {
+    Block,  ///< The producer waits up to block_timeout, then is rejected
+    Evict,  ///< The consumer skips its oldest bytes, see dropped_bytes
+    Flag    ///< Like Evict, and the next read fails with BufferOverflow
+  };
+
+  /**
+   * @struct Options
+   * @brief Construction parameters of the stream
+   */
+  struct Options {
+    size_t max_buffer_size = DEFAULT_BUFFER_SIZE;  ///< Buffer capacity
+    /// Most bytes a consumer may trail the newest data; 0 or anything
+    /// above max_buffer_size means max_buffer_size
+    size_t max_lag = 0;
+    /// Treatment of consumers that would exceed max_lag
+    LagPolicy lag_policy = LagPolicy::Evict;
+    /// Producer wait bound for LagPolicy::Block
+    std::chrono::milliseconds block_timeout = DEFAULT_BLOCK_TIMEOUT;
+  };
+
+  /**
+   * @class Consumer
+   * @brief Subscription through which one reader receives the stream
+   *
+   * A handle is used by one thread at a time and must not outlive the
+   * stream. Destroying it releases the data only it had left to read.
+   */
+  class Consumer {
+   public:
+    Consumer(Consumer&& other) noexcept;
+    Consumer& operator=(Consumer&& other) noexcept;
+    Consumer(const Consumer&) = delete;
+    Consumer& operator=(const Consumer&) = delete;
+    ~Consumer();
+
+    /**
+     * @brief Read the next data of this consumer
+     * @param min_bytes Minimum number of bytes to retrieve (default:
+     * ByteStreamController::MIN_READ_SIZE)
+     * @param max_bytes Maximum number of bytes to retrieve (default:
+     * unlimited)
+     * @param timeout Maximum time to wait for data (default:
+     * DEFAULT_READ_TIMEOUT)
+     * @return Result whose dropped_bytes counts the bytes this consumer
+     * lost to eviction since its previous read
+     *
+     * Under LagPolicy::Flag the first read after an eviction returns no
+     * data and ErrorCode::BufferOverflow; later reads resume with the
+     * oldest data still buffered.
+     */
+    Result read(size_t min_bytes = ByteStreamController::MIN_READ_SIZE,
+                size_t max_bytes = std::numeric_limits<size_t>::max(),
+                std::chrono::milliseconds timeout = DEFAULT_READ_TIMEOUT);
+
+    /// @return Bytes added that this consumer has not read yet
+    [[nodiscard]] size_t lag() const;
+
+   private:
+    friend class BroadcastStream;
+
+    Consumer(BroadcastStream* stream, Cursor* cursor) noexcept;
+
+    // Unsubscribes from the stream, leaving the handle empty.
+    void reset() noexcept;
+
+    BroadcastStream* stream_;  ///< Owning stream
+    Cursor* cursor_;           ///< Read position inside the stream
+  };
+
+  /**
+   * @brief Construct a new BroadcastStream object
+   * @param max_buffer_size Maximum buffer size in bytes (default:
+   * DEFAULT_BUFFER_SIZE)
+   */
+  explicit BroadcastStream(size_t max_buffer_size = DEFAULT_BUFFER_SIZE);
+
+  /**
+   * @brief Construct a new BroadcastStream object
+   * @param options Buffer size and lag handling
+   */
+  explicit BroadcastStream(const Options& options);
+
+  /**
+   * @brief Destroy the BroadcastStream object
+   * Stops the stream; all consumers must be gone by then
+   */
+  ~BroadcastStream();
+
+  // Delete copy and move operations
+  BroadcastStream(const BroadcastStream&) = delete;
+  BroadcastStream& operator=(const BroadcastStream&) = delete;
+  BroadcastStream(BroadcastStream&&) = delete;
+  BroadcastStream& operator=(BroadcastStream&&) = delete;
+
+  /**
+   * @brief Stop the stream
+   *
+   * Producers are rejected and waiting consumers wake up. Consumers still
+   * receive the data buffered for them, flagged ErrorCode::ControllerStopped.
+   */
+  void stop();
+
+  /**
+   * @brief Start the stream
+   *
+   * Resets the stream to operational state
+   */
+  void start();
+
+  /**
+   * @brief Add data for every current consumer
+   * @param data Span of bytes to add
+   * @return ErrorCode::BufferOverflow if the data exceeds max_lag or a
+   * consumer stayed too far behind under LagPolicy::Block
+   *
+   * The data is copied into the shared buffer once, whatever the number of
+   * consumers.
+   */
+  ErrorCode add_data(ByteSpan data);
+
+  /**
+   * @brief Subscribe a new consumer
+   * @return Handle reading the data added from now on (see Consumer)
+   */
+  Consumer subscribe();
+
+  /**
+   * @brief Get the number of subscribed consumers
+   * @return Live Consumer handles
+   */
+  size_t consumer_count() const;
+
+  /**
+   * @brief Get current buffer size
+   * @return Bytes the slowest consumer has not read yet
+   */
+  size_t current_buffer_size() const;
+
+  /**
+   * @brief Check if stream is stopped
+   * @return true if stream is stopped, false otherwise
+   */
+  bool is_stopped() const;
+
+ private:
+  mutable std::mutex mutex_;    ///< Guards everything below
+  std::condition_variable cv_;  ///< Consumers waiting for data
+  std::condition_variable producer_cv_;  ///< Producers waiting for consumers
+  const size_t max_lag_;                 ///< Bound on any consumer's lag
+  const LagPolicy lag_policy_;           ///< Treatment of slow consumers
+  const std::chrono::milliseconds block_timeout_;  ///< Block policy bound
+  std::vector<Byte> storage_;  ///< Ring storage, power-of-two sized
+  size_t written_ = 0;  ///< Bytes ever added, wrapping (end of the stream)
+  std::vector<std::unique_ptr<Cursor>> cursors_;  ///< Subscribed consumers
+  size_t sleeping_consumers_ = 0;   ///< Consumers waiting on cv_
+  size_t blocked_producers_ = 0;    ///< Producers waiting on producer_cv_
+  bool stopped_ = false;            ///< Stopped state
+
+  // True if adding the given size keeps every consumer within max_lag_.
+  [[nodiscard]] bool fits(size_t bytes) const noexcept;
+
+  // Moves consumers that the given add would push past max_lag_ forward.
+  void evict_lagging(size_t bytes);
+
+  // Copies between the ring and linear memory at a stream position.
+  void copy_in(size_t position, ByteSpan data);
+  void copy_out(size_t position, std::span<Byte> out) const;
+
+  // Read of one consumer, see Consumer::read().
+  Result read(Cursor& cursor, size_t min_bytes, size_t max_bytes,
+              std::chrono::milliseconds timeout);
+
+  // Removes a consumer and lets producers waiting for it continue.
+  void unsubscribe(Cursor* cursor);
+};
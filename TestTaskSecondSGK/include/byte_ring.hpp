@@ -0,0 +1,135 @@
+/**
+ * @file byte_ring.hpp
+ * @brief Fixed-capacity single-producer/single-consumer byte ring.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <span>
+
+/**
+ * @class ByteRing
+ * @brief Lock-free byte ring for exactly one producer and one consumer.
+ *
+ * Several producers or consumers may share a ring as long as each side is
+ * serialized by an external lock.
+ *
+ * Storage is rounded up to a power of two so that positions can be wrapped
+ * with a mask. The head (write) and tail (read) positions grow monotonically
+ * and live on separate cache lines; the producer publishes with a release
+ * store of the head and the consumer frees space with a release store of the
+ * tail. The logical capacity passed to the constructor is the limit that is
+ * enforced, not the rounded storage size.
+ */
+class ByteRing {
+ public:
+  using Byte = std::byte;  ///< Type alias for byte
+
+  /// Assumed size of a cache line used to separate the indices.
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+
+  /**
+   * @brief Construct a ring able to hold @p capacity bytes
+   * @param capacity Logical capacity in bytes
+   */
+  explicit ByteRing(size_t capacity);
+
+  /**
+   * @brief Construct a ring over storage owned by the caller
+   * @param storage At least storage_size(capacity) bytes that outlive the ring
+   * @param capacity Logical capacity in bytes
+   */
+  ByteRing(Byte* storage, size_t capacity) noexcept;
+
+  /**
+   * @brief Storage a ring of the given capacity needs
+   * @param capacity Logical capacity in bytes
+   * @return Capacity rounded up to a power of two
+   */
+  [[nodiscard]] static size_t storage_size(size_t capacity) noexcept;
+
+  ByteRing(const ByteRing&) = delete;
+  ByteRing& operator=(const ByteRing&) = delete;
+  ByteRing(ByteRing&&) = delete;
+  ByteRing& operator=(ByteRing&&) = delete;
+  ~ByteRing() = default;
+
+  /// @return Logical capacity in bytes.
+  [[nodiscard]] size_t capacity() const noexcept { return capacity_; }
+
+  /// @return Number of bytes currently stored (safe from any thread).
+  [[nodiscard]] size_t size() const noexcept {
+    // The tail is loaded first so that it never runs past the head, and the
+    // head may have moved on meanwhile, so the result is clamped.
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    const size_t head = head_.load(std::memory_order_acquire);
+    return std::min(head - tail, capacity_);
+  }
+
+  /// @return Number of bytes that can still be appended.
+  [[nodiscard]] size_t free_space() const noexcept {
+    return capacity_ - size();
+  }
+
+  /// @return True if the ring holds no bytes.
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+  /**
+   * @brief Append all of @p data or nothing (producer side)
+   * @param data Bytes to append
+   * @return true if the bytes were appended, false if they do not fit
+   */
+  bool try_push(std::span<const Byte> data) noexcept;
+
+  /**
+   * @brief Borrow free space at the write position (producer side)
+   * @param max_bytes Upper bound on the number of bytes returned
+   * @return Up to two contiguous regions of free space in write order
+   *
+   * Nothing becomes visible to the consumer until commit() is called.
+   */
+  std::array<std::span<Byte>, 2> writable(size_t max_bytes) noexcept;
+
+  /**
+   * @brief Publish bytes written into writable() regions (producer side)
+   * @param count Number of bytes to publish, clamped to the free space
+   */
+  void commit(size_t count) noexcept;
+
+  /**
+   * @brief Borrow the oldest readable bytes in place (consumer side)
+   * @param max_bytes Upper bound on the number of bytes returned
+   * @return Up to two contiguous regions; the second one is non-empty only
+   * when the data wraps around the end of the storage
+   *
+   * The bytes stay reserved until they are released with consume().
+   */
+  std::array<std::span<const Byte>, 2> readable(size_t max_bytes) noexcept;
+
+  /**
+   * @brief Release the oldest bytes back to the producer (consumer side)
+   * @param count Number of bytes to release, clamped to size()
+   */
+  void consume(size_t count) noexcept;
+
+ private:
+  const size_t capacity_;          ///< Logical capacity
+  const size_t mask_;              ///< Storage size minus one
+  std::unique_ptr<Byte[]> owned_;  ///< Storage allocated by the ring
+  Byte* const data_;               ///< Power-of-two sized storage
+
+  /// Write position, owned by the producer.
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+  /// Producer's last observed tail, refreshed only when space looks short.
+  size_t cached_tail_{0};
+
+  /// Read position, owned by the consumer.
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+  /// Consumer's last observed head, refreshed only when data looks short.
+  size_t cached_head_{0};
+};
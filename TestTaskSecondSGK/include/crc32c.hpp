@@ -0,0 +1,31 @@
+/**
+ * @file crc32c.hpp
+ * @brief CRC32C (Castagnoli) checksum, optionally fused with a copy.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/**
+ * @brief Extend a CRC32C over more data
+ * @param crc CRC32C of the preceding data (0 for none)
+ * @param data Bytes that follow the preceding data
+ * @return CRC32C of the preceding data followed by @p data
+ *
+ * Uses the SSE4.2 or ARMv8 CRC instructions when the CPU has them and a
+ * table otherwise; all variants give the same result.
+ */
+uint32_t crc32c_extend(uint32_t crc, std::span<const std::byte> data) noexcept;
+
+/**
+ * @brief Copy bytes and extend a CRC32C over them in the same pass
+ * @param crc CRC32C of the preceding data (0 for none)
+ * @param dst Destination of at least @p src.size() bytes, not overlapping
+ * @param src Bytes to copy
+ * @return crc32c_extend(crc, src)
+ */
+uint32_t crc32c_copy(uint32_t crc, std::byte* dst,
+                     std::span<const std::byte> src) noexcept;
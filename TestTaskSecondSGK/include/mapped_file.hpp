@@ -0,0 +1,57 @@
+/**
+ * @file mapped_file.hpp
+ * @brief Temporary file mapped read-write into memory.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <span>
+#include <system_error>
+
+/**
+ * @class MappedFile
+ * @brief RAII owner of a shared read-write mapping of a scratch file
+ *
+ * The file is created (or truncated) at the given path, sized and mapped,
+ * and removed again as soon as possible: right after mapping on POSIX, when
+ * the mapping is closed on Windows. Its pages are backed by the file rather
+ * than by swap, so the kernel may write them back and reclaim them under
+ * memory pressure.
+ */
+class MappedFile {
+ public:
+  using Byte = std::byte;  ///< Type alias for byte
+
+  /**
+   * @brief Create and map a scratch file
+   * @param path Location of the file; its directory must exist
+   * @param size Size of the file and of the mapping in bytes
+   * @return The mapping, or the system error that prevented it
+   */
+  static std::expected<MappedFile, std::error_code> create(
+      const std::filesystem::path& path, size_t size);
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+
+  /// @return The mapped bytes
+  [[nodiscard]] std::span<Byte> bytes() const noexcept {
+    return {data_, size_};
+  }
+
+ private:
+  MappedFile(Byte* data, size_t size, void* handle) noexcept;
+
+  // Unmaps and closes, leaving the object empty.
+  void reset() noexcept;
+
+  Byte* data_ = nullptr;    ///< Start of the mapping
+  size_t size_ = 0;         ///< Length of the mapping
+  void* handle_ = nullptr;  ///< File handle kept open on Windows
+};
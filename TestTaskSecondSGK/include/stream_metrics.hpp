@@ -0,0 +1,124 @@
+/**
+ * @file stream_metrics.hpp
+ * @brief Lock-free runtime counters of a byte stream.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class StreamMetrics
+ * @brief Relaxed counters sharded over cache lines, summed on demand
+ *
+ * Every thread updates the shard it was assigned on first use, so producers
+ * and readers running on different cores do not bounce a shared cache line.
+ * snapshot() sums the shards without stopping writers; the counters of one
+ * snapshot are individually exact but not taken at a single instant.
+ */
+class StreamMetrics {
+ public:
+  /// Assumed size of a cache line used to separate the shards.
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+  /// Number of counter shards threads are spread over.
+  static constexpr size_t SHARD_COUNT = 16;
+  /// Number of buckets of the read wait histogram.
+  static constexpr size_t WAIT_BUCKET_COUNT = 24;
+
+  /**
+   * @enum DropReason
+   * @brief Why bytes offered by a producer did not reach a reader
+   */
+  enum class DropReason : uint8_t {
+    Rejected,      ///< Refused with BufferOverflow (Reject, batches, reserve)
+    BlockTimeout,  ///< Refused after waiting block_timeout for space
+    Evicted,       ///< Old unread bytes discarded by DropOldest
+    Truncated,     ///< Tail of new data discarded by DropNewest
+    Discarded,     ///< Still buffered when close_and_drain() timed out
+  };
+
+  /// Number of DropReason values.
+  static constexpr size_t DROP_REASON_COUNT = 5;
+
+  /**
+   * @struct Snapshot
+   * @brief Point-in-time copy of all counters
+   *
+   * wait_histogram[0] counts reads that waited less than 1 us; bucket i > 0
+   * counts waits in [2^(i-1), 2^i) us and the last bucket everything longer.
+   */
+  struct Snapshot {
+    uint64_t bytes_in = 0;       ///< Bytes accepted into the buffer
+    uint64_t bytes_out = 0;      ///< Bytes consumed by readers
+    uint64_t reads = 0;          ///< Completed read_view/sync_get_data calls
+    uint64_t read_timeouts = 0;  ///< Reads that ended with Timeout
+    /// Dropped or rejected bytes, indexed by DropReason
+    std::array<uint64_t, DROP_REASON_COUNT> dropped_bytes{};
+    size_t high_water_mark = 0;  ///< Highest observed buffer occupancy
+    /// Time readers spent waiting for data, see above
+    std::array<uint64_t, WAIT_BUCKET_COUNT> wait_histogram{};
+
+    /**
+     * @brief Dropped bytes for one reason
+     * @param reason Reason to look up
+     * @return Bytes counted under @p reason
+     */
+    [[nodiscard]] uint64_t dropped(DropReason reason) const noexcept {
+      return dropped_bytes[static_cast<size_t>(reason)];
+    }
+
+    /**
+     * @brief Exclusive upper bound of a histogram bucket
+     * @param bucket Bucket index below WAIT_BUCKET_COUNT - 1
+     * @return Upper bound of the bucket in microseconds
+     */
+    static constexpr std::chrono::microseconds wait_bucket_bound(
+        size_t bucket) noexcept {
+      return std::chrono::microseconds(int64_t{1} << bucket);
+    }
+  };
+
+  /// Counts bytes accepted into the buffer.
+  void add_in(size_t bytes) noexcept;
+
+  /// Counts bytes released by readers.
+  void add_out(size_t bytes) noexcept;
+
+  /// Counts bytes that were dropped or rejected for @p reason.
+  void add_dropped(DropReason reason, size_t bytes) noexcept;
+
+  /// Counts one read and the time it spent waiting for data.
+  void add_read(std::chrono::nanoseconds waited) noexcept;
+
+  /// Counts one read that timed out.
+  void add_read_timeout() noexcept;
+
+  /// Raises the high-water mark to @p size if it is higher.
+  void observe_size(size_t size) noexcept;
+
+  /**
+   * @brief Sum all shards
+   * @return Current counter values
+   */
+  [[nodiscard]] Snapshot snapshot() const noexcept;
+
+ private:
+  struct alignas(CACHE_LINE_SIZE) Shard {
+    std::atomic<uint64_t> bytes_in{0};
+    std::atomic<uint64_t> bytes_out{0};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> read_timeouts{0};
+    std::array<std::atomic<uint64_t>, DROP_REASON_COUNT> dropped_bytes{};
+    std::array<std::atomic<uint64_t>, WAIT_BUCKET_COUNT> wait_histogram{};
+  };
+
+  // Shard owned by the calling thread.
+  Shard& local_shard() noexcept;
+
+  std::array<Shard, SHARD_COUNT> shards_;
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> high_water_mark_{0};
+};
@@ -1,11 +1,147 @@
 #include "../include/async_controller.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+#include <immintrin.h>
+#elif defined(_M_ARM64)
+#include <intrin.h>
+#endif
+
+namespace {
+
+// Tells the CPU that the thread is busy-waiting.
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+  _mm_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#elif defined(_M_ARM64)
+  __yield();
+#endif
+}
+
+// Polls ready() within the spin and yield budgets of the strategy.
+template <typename Ready>
+bool poll_until(const ByteStreamController::WaitStrategy& strategy,
+                const Ready& ready) {
+  for (uint32_t i = 0; i < strategy.spin_count; ++i) {
+    if (ready()) {
+      return true;
+    }
+    cpu_relax();
+  }
+  for (uint32_t i = 0; i < strategy.yield_count; ++i) {
+    if (ready()) {
+      return true;
+    }
+    std::this_thread::yield();
+  }
+  return false;
+}
+
+}  // namespace
+
+struct ByteStreamController::ProducerSlab {
+  ProducerSlab(uint32_t producer_id, size_t capacity)
+      : id(producer_id), ring(capacity) {}
+
+  const uint32_t id;               ///< Owning producer id
+  ByteRing ring;                   ///< Bytes not merged yet
+  std::atomic<bool> retired{false};  ///< Producer handle was destroyed
+  std::atomic<bool> writing{false};  ///< An add is under way
+};
+
+ByteStreamController::Producer::Producer(ByteStreamController* controller,
+                                         ProducerSlab* slab,
+                                         uint32_t id) noexcept
+    : controller_(controller), slab_(slab), id_(id) {}
+
+ByteStreamController::Producer::Producer(Producer&& other) noexcept
+    : controller_(std::exchange(other.controller_, nullptr)),
+      slab_(std::exchange(other.slab_, nullptr)),
+      id_(other.id_) {}
+
+ByteStreamController::Producer& ByteStreamController::Producer::operator=(
+    Producer&& other) noexcept {
+  if (this != &other) {
+    if (slab_ != nullptr) {
+      slab_->retired.store(true, std::memory_order_release);
+    }
+    controller_ = std::exchange(other.controller_, nullptr);
+    slab_ = std::exchange(other.slab_, nullptr);
+    id_ = other.id_;
+  }
+  return *this;
+}
+
+ByteStreamController::Producer::~Producer() {
+  if (slab_ != nullptr) {
+    slab_->retired.store(true, std::memory_order_release);
+  }
+}
+
+ByteStreamController::ErrorCode ByteStreamController::Producer::add_data(
+    ByteSpan data) {
+  if (controller_ == nullptr) {
+    return ErrorCode::InvalidArgs;
+  }
+  if (slab_ == nullptr) {
+    return controller_->async_add_data(data);
+  }
+  if (!controller_->begin_lock_free_write(slab_->writing)) {
+    return ErrorCode::ControllerStopped;
+  }
+  const ErrorCode error = controller_->push_lock_free(slab_->ring, data);
+  controller_->end_lock_free_write(slab_->writing);
+  return error;
+}
 
 ByteStreamController::ByteStreamController(size_t max_buffer_size)
-    : max_buffer_size_(max_buffer_size), stopped_(false) {
-  buffer_.reserve(max_buffer_size);
+    : ByteStreamController(Options{max_buffer_size, Backend::Mutex}) {}
+
+ByteStreamController::ByteStreamController(const Options& options)
+    : max_buffer_size_(options.max_buffer_size),
+      backend_(options.backend),
+      overflow_policy_(options.overflow_policy),
+      block_timeout_(options.block_timeout),
+      wait_strategy_(options.wait_strategy),
+      stopped_(false),
+      ring_(options.max_buffer_size),
+      checksum_(options.checksum),
+      producer_slab_size_(options.producer_slab_size),
+      tag_producers_(options.tag_producers &&
+                     options.backend == Backend::Sharded),
+      framed_(options.framed && options.backend == Backend::Mutex) {
+  if (options.pool_results) {
+    // One pool bucket per power of two up to the largest possible read.
+    result_pool_ = std::make_unique<std::pmr::synchronized_pool_resource>(
+        std::pmr::pool_options{0, options.max_buffer_size});
+  }
+
+  if (backend_ != Backend::Mutex || options.spill_capacity == 0 ||
+      options.spill_path.empty()) {
+    return;
+  }
+
+  auto file = MappedFile::create(
+      options.spill_path, ByteRing::storage_size(options.spill_capacity));
+  if (!file) {
+    spill_error_ = file.error();
+    return;
+  }
+  spill_file_ = std::move(*file);
+  spill_ = std::make_unique<ByteRing>(spill_file_->bytes().data(),
+                                      options.spill_capacity);
 }
 
 ByteStreamController::~ByteStreamController() { stop(); }
@@ -16,81 +152,1182 @@ void ByteStreamController::stop() {
     stopped_ = true;
   }
   cv_.notify_all();
+  producer_cv_.notify_all();
+  resume_async_waiters();
 }
 
 void ByteStreamController::start() {
   const std::scoped_lock lock(mutex_);
   stopped_ = false;
+  closed_ = false;
+  draining_ = false;
   cv_.notify_all();
 }
 
+ByteStreamController::DrainResult ByteStreamController::close_and_drain(
+    std::chrono::steady_clock::time_point deadline) {
+  if (stopped_.load(std::memory_order_acquire) || closed_.exchange(true)) {
+    return DrainResult{ErrorCode::ControllerStopped, 0, 0};
+  }
+
+  // The closer waits on producer_cv_ like a producer blocked for space:
+  // commit(), consume(), merge_slabs() and end_lock_free_write() notify it.
+  std::unique_lock lock(mutex_);
+  blocked_producers_.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  // Producers waiting for space or for their turn give up.
+  producer_cv_.notify_all();
+  producer_cv_.wait_until(
+      lock, deadline, [this] { return stopped_ || !writes_in_flight(); });
+  const size_t closed_with = buffered_locked();
+
+  // Waiting readers return what is left right away.
+  draining_ = true;
+  lock.unlock();
+  cv_.notify_all();
+  resume_async_waiters();
+  lock.lock();
+  producer_cv_.wait_until(lock, deadline, [this] {
+    return stopped_ || buffered_locked() == 0;
+  });
+  blocked_producers_.fetch_sub(1, std::memory_order_relaxed);
+
+  size_t discarded = buffered_locked();
+  if (backend_ != Backend::Spsc) {
+    discarded = discard_buffered();
+  }
+  stopped_ = true;
+  lock.unlock();
+
+  cv_.notify_all();
+  producer_cv_.notify_all();
+  resume_async_waiters();
+  // An add that was still under way at the deadline may have raised the
+  // count above what was buffered at the close.
+  return DrainResult{
+      discarded > 0 ? ErrorCode::Timeout : ErrorCode::NoError,
+      closed_with - std::min(discarded, closed_with), discarded};
+}
+
+bool ByteStreamController::accepting() const noexcept {
+  return !stopped_.load(std::memory_order_relaxed) &&
+         !closed_.load(std::memory_order_acquire);
+}
+
+bool ByteStreamController::readers_released() const noexcept {
+  return stopped_.load(std::memory_order_acquire) ||
+         draining_.load(std::memory_order_acquire);
+}
+
+bool ByteStreamController::begin_lock_free_write(std::atomic<bool>& writing) {
+  // Pairs with the exchange in close_and_drain: either the closer sees the
+  // mark and waits for the add, or the add sees closed_.
+  writing.store(true, std::memory_order_seq_cst);
+  if (closed_.load(std::memory_order_seq_cst) ||
+      stopped_.load(std::memory_order_relaxed)) {
+    end_lock_free_write(writing);
+    return false;
+  }
+  return true;
+}
+
+void ByteStreamController::end_lock_free_write(std::atomic<bool>& writing) {
+  writing.store(false, std::memory_order_seq_cst);
+  if (closed_.load(std::memory_order_seq_cst)) {
+    { const std::scoped_lock lock(mutex_); }
+    producer_cv_.notify_all();
+  }
+}
+
+bool ByteStreamController::writes_in_flight() const {
+  if (backend_ == Backend::Spsc) {
+    return spsc_writing_.load(std::memory_order_seq_cst);
+  }
+  return reserved_bytes_ > 0 ||
+         std::ranges::any_of(slabs_, [](const auto& slab) {
+           return slab->writing.load(std::memory_order_seq_cst);
+         });
+}
+
+size_t ByteStreamController::discard_buffered() {
+  size_t discarded = ring_.size();
+  ring_.consume(ring_.size());
+  if (spill_ != nullptr) {
+    discarded += spill_->size();
+    spill_->consume(spill_->size());
+  }
+  for (const auto& slab : slabs_) {
+    const size_t staged = slab->ring.size();
+    staged_bytes_.fetch_sub(static_cast<int64_t>(staged),
+                            std::memory_order_relaxed);
+    discarded += staged;
+    slab->ring.consume(staged);
+  }
+  frames_.clear();
+  tags_.clear();
+  tagged_bytes_ = 0;
+  metrics_.add_dropped(DropReason::Discarded, discarded);
+  return discarded;
+}
+
 ByteStreamController::ErrorCode ByteStreamController::async_add_data(
     ByteSpan data) {
-  if (stopped_.load(std::memory_order_relaxed)) {
+  if (!accepting()) {
     return ErrorCode::ControllerStopped;
   }
 
+  if (backend_ == Backend::Spsc) {
+    if (!begin_lock_free_write(spsc_writing_)) {
+      return ErrorCode::ControllerStopped;
+    }
+    const ErrorCode error = push_lock_free(ring_, data);
+    end_lock_free_write(spsc_writing_);
+    return error;
+  }
+
+  bool wake = false;
+  bool resume = false;
   {
-    const std::scoped_lock lock(mutex_);
+    std::unique_lock lock(mutex_);
+    if (!wait_producer_turn(lock, data.size())) {
+      return ErrorCode::ControllerStopped;
+    }
 
-    if (buffer_.size() + data.size() > max_buffer_size_) {
+    make_room(data.size());
+    ByteRing& target = write_ring(data.size());
+    if (target.try_push(data)) {
+      metrics_.add_in(data.size());
+      push_frame(data.size());
+    } else if (truncates_on_overflow()) {
+      push_prefix(target, data);
+    } else {
+      metrics_.add_dropped(rejection_reason(), data.size());
       return ErrorCode::BufferOverflow;
     }
+    metrics_.observe_size(buffered_locked());
+    wake = has_sleeping_readers();
+    resume = has_async_waiters();
+  }
+
+  if (wake) {
+    cv_.notify_one();
+  }
+  if (resume) {
+    resume_async_waiters();
+  }
+  return ErrorCode::NoError;
+}
+
+ByteStreamController::AddResult ByteStreamController::async_add_data(
+    std::span<const ByteSpan> parts, BatchPolicy policy) {
+  if (!accepting()) {
+    return AddResult{ErrorCode::ControllerStopped, 0};
+  }
+
+  size_t total = 0;
+  for (const ByteSpan part : parts) {
+    total += part.size();
+  }
+
+  AddResult result;
+  if (backend_ == Backend::Spsc) {
+    if (!begin_lock_free_write(spsc_writing_)) {
+      return AddResult{ErrorCode::ControllerStopped, 0};
+    }
+    if (overflow_policy_ == OverflowPolicy::Block &&
+        ring_.free_space() < total) {
+      spsc_wait_space(ring_, total);
+    }
+    result = push_parts(parts, total, policy);
+    end_lock_free_write(spsc_writing_);
+    if (result.accepted_bytes > 0) {
+      wake_reader();
+    }
+    return result;
+  }
+
+  bool wake = false;
+  bool resume = false;
+  {
+    std::unique_lock lock(mutex_);
+    if (!wait_producer_turn(lock, total)) {
+      return AddResult{ErrorCode::ControllerStopped, 0};
+    }
+    make_room(total);
+    result = push_parts(parts, total, policy);
+    wake = result.accepted_bytes > 0 && has_sleeping_readers();
+    resume = result.accepted_bytes > 0 && has_async_waiters();
+  }
+
+  if (wake) {
+    cv_.notify_one();
+  }
+  if (resume) {
+    resume_async_waiters();
+  }
+  return result;
+}
+
+std::span<ByteStreamController::Byte> ByteStreamController::reserve(
+    size_t bytes) {
+  if (bytes == 0 || !accepting()) {
+    return {};
+  }
+
+  if (backend_ == Backend::Spsc) {
+    // The mark stays set until commit().
+    if (!begin_lock_free_write(spsc_writing_)) {
+      return {};
+    }
+    if (overflow_policy_ == OverflowPolicy::Block &&
+        ring_.free_space() < bytes) {
+      spsc_wait_space(ring_, bytes);
+    }
+    const std::span<Byte> region = reserve_region(bytes);
+    if (region.empty()) {
+      end_lock_free_write(spsc_writing_);
+    }
+    return region;
+  }
 
-    buffer_.insert(buffer_.end(), data.begin(), data.end());
+  std::unique_lock lock(mutex_);
+  if (!wait_producer_turn(lock, bytes)) {
+    return {};
   }
+  make_room(bytes);
+  return reserve_region(bytes);
+}
 
-  cv_.notify_one();
+ByteStreamController::Producer ByteStreamController::register_producer() {
+  const std::scoped_lock lock(mutex_);
+  const uint32_t id = ++last_producer_id_;
+
+  if (backend_ != Backend::Sharded) {
+    return Producer(this, nullptr, id);
+  }
+
+  slabs_.push_back(std::make_unique<ProducerSlab>(id, producer_slab_size_));
+  return Producer(this, slabs_.back().get(), id);
+}
+
+ByteStreamController::ErrorCode ByteStreamController::commit(size_t bytes) {
+  if (backend_ == Backend::Spsc) {
+    // Only the producer touches the reservation.
+    if (!fits_reservation(bytes)) {
+      return ErrorCode::InvalidArgs;
+    }
+    publish_reserved(bytes);
+    end_lock_free_write(spsc_writing_);
+    wake_reader();
+    return ErrorCode::NoError;
+  }
+
+  bool wake = false;
+  bool resume = false;
+  {
+    const std::scoped_lock lock(mutex_);
+    if (!fits_reservation(bytes)) {
+      return ErrorCode::InvalidArgs;
+    }
+    publish_reserved(bytes);
+    wake = has_sleeping_readers();
+    resume = has_async_waiters();
+  }
+
+  producer_cv_.notify_all();
+  if (wake) {
+    cv_.notify_one();
+  }
+  if (resume) {
+    resume_async_waiters();
+  }
   return ErrorCode::NoError;
 }
 
+bool ByteStreamController::wait_producer_turn(
+    std::unique_lock<std::mutex>& lock, size_t bytes) {
+  auto turn = [this] { return !accepting() || reserved_bytes_ == 0; };
+
+  if (overflow_policy_ == OverflowPolicy::Block &&
+      bytes <= max_write_size()) {
+    blocked_producers_.fetch_add(1, std::memory_order_relaxed);
+    producer_cv_.wait_for(lock, block_timeout_, [this, &turn, bytes] {
+      return turn() &&
+             (!accepting() || write_ring(bytes).free_space() >= bytes);
+    });
+    blocked_producers_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  producer_cv_.wait(lock, turn);
+  return accepting();
+}
+
+void ByteStreamController::make_room(size_t bytes) {
+  // Bytes under an open ReadView cannot be evicted. With a spill file new
+  // data goes behind the spilled bytes, so evicting from ring_ would not
+  // make room for it; the data is truncated instead.
+  if (overflow_policy_ != OverflowPolicy::DropOldest || view_open_ ||
+      spill_ != nullptr) {
+    return;
+  }
+
+  const size_t free_space = ring_.free_space();
+  if (free_space < bytes) {
+    size_t evicted = std::min(bytes - free_space, ring_.size());
+    if (framed_) {
+      // Evict whole messages only.
+      size_t whole = 0;
+      while (whole < evicted && !frames_.empty()) {
+        whole += frames_.front();
+        frames_.pop_front();
+      }
+      evicted = whole;
+    }
+    ring_.consume(evicted);
+    pop_tags(evicted);
+    record_drop(evicted);
+    metrics_.add_dropped(DropReason::Evicted, evicted);
+  }
+}
+
+bool ByteStreamController::truncates_on_overflow() const noexcept {
+  return overflow_policy_ == OverflowPolicy::DropNewest ||
+         overflow_policy_ == OverflowPolicy::DropOldest;
+}
+
+size_t ByteStreamController::push_prefix(ByteRing& ring, ByteSpan data) {
+  // A message is never torn, so framed mode drops it whole.
+  const size_t kept = framed_ ? 0 : std::min(data.size(), ring.free_space());
+  ring.try_push(data.first(kept));
+  record_drop(data.size() - kept);
+  metrics_.add_in(kept);
+  metrics_.add_dropped(DropReason::Truncated, data.size() - kept);
+  return kept;
+}
+
+ByteStreamController::DropReason ByteStreamController::rejection_reason()
+    const noexcept {
+  return overflow_policy_ == OverflowPolicy::Block ? DropReason::BlockTimeout
+                                                   : DropReason::Rejected;
+}
+
+void ByteStreamController::record_drop(size_t bytes) noexcept {
+  if (bytes > 0) {
+    dropped_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+  }
+}
+
+ByteStreamController::AddResult ByteStreamController::push_parts(
+    std::span<const ByteSpan> parts, size_t total, BatchPolicy policy) {
+  if (framed_) {
+    policy = BatchPolicy::AllOrNothing;
+  }
+
+  ByteRing& ring = write_ring(total);
+  const auto [first, second] = ring.writable(total);
+  const size_t accepted = first.size() + second.size();
+  if (accepted < total && policy == BatchPolicy::AllOrNothing) {
+    metrics_.add_dropped(rejection_reason(), total);
+    return AddResult{ErrorCode::BufferOverflow, 0};
+  }
+
+  // Scatter the parts over the (up to two) free regions.
+  std::span<Byte> target = first;
+  size_t left = accepted;
+  for (ByteSpan part : parts) {
+    part = part.first(std::min(part.size(), left));
+    left -= part.size();
+    while (!part.empty()) {
+      if (target.empty()) {
+        target = second;
+      }
+      const size_t chunk = std::min(part.size(), target.size());
+      std::ranges::copy(part.first(chunk), target.begin());
+      part = part.subspan(chunk);
+      target = target.subspan(chunk);
+    }
+  }
+  ring.commit(accepted);
+  push_frame(accepted);
+  metrics_.add_in(accepted);
+  metrics_.add_dropped(rejection_reason(), total - accepted);
+  metrics_.observe_size(buffered_locked());
+
+  return AddResult{
+      accepted < total ? ErrorCode::BufferOverflow : ErrorCode::NoError,
+      accepted};
+}
+
+std::span<ByteStreamController::Byte> ByteStreamController::reserve_region(
+    size_t bytes) {
+  ByteRing& target = write_ring(bytes);
+  const auto [first, second] = target.writable(bytes);
+  if (first.size() + second.size() < bytes) {
+    metrics_.add_dropped(rejection_reason(), bytes);
+    return {};
+  }
+
+  reserved_ring_ = &target;
+  reserved_bytes_ = bytes;
+  reserved_in_staging_ = !second.empty();
+  if (!reserved_in_staging_) {
+    return first;
+  }
+
+  // The free space wraps around the end of the ring; hand out a contiguous
+  // scratch block and copy it in on commit.
+  staging_.resize(bytes);
+  return staging_;
+}
+
+bool ByteStreamController::fits_reservation(size_t bytes) const noexcept {
+  return reserved_bytes_ > 0 && bytes <= reserved_bytes_;
+}
+
+void ByteStreamController::publish_reserved(size_t bytes) {
+  reserved_bytes_ = 0;
+  if (reserved_in_staging_) {
+    reserved_ring_->try_push(ByteSpan(staging_).first(bytes));
+  } else {
+    reserved_ring_->commit(bytes);
+  }
+  push_frame(bytes);
+  metrics_.add_in(bytes);
+  metrics_.observe_size(buffered_locked());
+}
+
 ByteStreamController::Result ByteStreamController::sync_get_data(
     size_t min_bytes, size_t max_bytes, std::chrono::milliseconds timeout) {
+  ReadView view = read_view(min_bytes, max_bytes, timeout);
+  if (view.size() == 0) {
+    return Result{ByteVec{}, view.error, view.dropped_bytes, view.buffer_size,
+                  {}};
+  }
+
+  const size_t bytes_to_take = view.size();
+  ByteVec result;
+  uint32_t crc = 0;
+  if (checksum_) {
+    result.resize(bytes_to_take);
+    crc = copy_view(view, result.data());
+  } else {
+    result.reserve(bytes_to_take);
+    result.insert(result.end(), view.first.begin(), view.first.end());
+    result.insert(result.end(), view.second.begin(), view.second.end());
+  }
+  consume(bytes_to_take);
+
+  return Result{std::move(result), view.error,
+                view.dropped_bytes, current_buffer_size(),
+                std::move(view.chunks), crc};
+}
+
+bool ByteStreamController::wait_readable(std::unique_lock<std::mutex>& lock,
+                                         size_t min_bytes,
+                                         std::chrono::milliseconds timeout) {
+  const auto wait_start = std::chrono::steady_clock::now();
+
+  // Sharded data sits in slabs that can only be inspected under the lock, so
+  // only the Mutex backend polls before locking.
+  if (backend_ == Backend::Mutex) {
+    poll_until(wait_strategy_, [this, min_bytes] {
+      return readers_released() || ring_.size() >= min_bytes;
+    });
+  }
+
+  lock.lock();
+
+  // Producers only notify registered sleepers, see has_sleeping_readers()
+  // and wake_reader().
+  sleeping_readers_.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const bool ready = cv_.wait_for(lock, timeout, [this, min_bytes] {
+    return stopped_ ||
+           (!view_open_ && (draining_ || readable_locked() >= min_bytes));
+  });
+  sleeping_readers_.fetch_sub(1, std::memory_order_relaxed);
+  record_read(wait_start, ready);
+  return ready;
+}
+
+ByteStreamController::CopyResult ByteStreamController::sync_get_data(
+    std::span<Byte> out, size_t min_bytes, std::chrono::milliseconds timeout) {
+  const ReadView view = read_view(min_bytes, out.size(), timeout);
+  const size_t taken = view.size();
+  if (taken == 0) {
+    return CopyResult{0, view.error, view.dropped_bytes, view.buffer_size};
+  }
+
+  const uint32_t crc = copy_view(view, out.data());
+  consume(taken);
+  return CopyResult{taken, view.error, view.dropped_bytes,
+                    current_buffer_size(), crc};
+}
+
+ByteStreamController::CopyResult ByteStreamController::sync_get_data(
+    ByteVec& out, size_t min_bytes, size_t max_bytes,
+    std::chrono::milliseconds timeout) {
+  return read_into(out, min_bytes, max_bytes, timeout);
+}
+
+ByteStreamController::CopyResult ByteStreamController::sync_get_data(
+    PooledByteVec& out, size_t min_bytes, size_t max_bytes,
+    std::chrono::milliseconds timeout) {
+  return read_into(out, min_bytes, max_bytes, timeout);
+}
+
+template <typename Vec>
+ByteStreamController::CopyResult ByteStreamController::read_into(
+    Vec& out, size_t min_bytes, size_t max_bytes,
+    std::chrono::milliseconds timeout) {
+  const ReadView view = read_view(min_bytes, max_bytes, timeout);
+  out.resize(view.size());
+  if (out.empty()) {
+    return CopyResult{0, view.error, view.dropped_bytes, view.buffer_size};
+  }
+
+  const uint32_t crc = copy_view(view, out.data());
+  consume(out.size());
+  return CopyResult{out.size(), view.error, view.dropped_bytes,
+                    current_buffer_size(), crc};
+}
+
+uint32_t ByteStreamController::copy_view(const ReadView& view,
+                                         Byte* dst) const {
+  if (!checksum_) {
+    std::ranges::copy(view.second, std::ranges::copy(view.first, dst).out);
+    return 0;
+  }
+  const uint32_t crc = crc32c_copy(0, dst, view.first);
+  return crc32c_copy(crc, dst + view.first.size(), view.second);
+}
+
+ByteStreamController::ReadView ByteStreamController::read_view(
+    size_t min_bytes, size_t max_bytes, std::chrono::milliseconds timeout) {
   if (min_bytes > max_bytes) {
-    return Result{ByteVec{}, ErrorCode::InvalidArgs, 0, buffer_.size()};
+    return ReadView{{}, {}, ErrorCode::InvalidArgs, 0, current_buffer_size(),
+                    {}};
   }
 
-  std::unique_lock lock(mutex_);
+  if (backend_ == Backend::Spsc) {
+    const auto wait_start = std::chrono::steady_clock::now();
+    const bool ready = spsc_wait(min_bytes, timeout);
+    record_read(wait_start, ready);
+    if (!ready) {
+      return ReadView{{}, {}, ErrorCode::Timeout, 0, ring_.size(), {}};
+    }
+    return make_view(max_bytes, stopped_.load(std::memory_order_acquire));
+  }
+
+  std::unique_lock lock(mutex_, std::defer_lock);
+  if (!wait_readable(lock, min_bytes, timeout)) {
+    return ReadView{{}, {}, ErrorCode::Timeout, 0, buffered_locked(), {}};
+  }
 
-  if (!cv_.wait_for(lock, timeout, [this, min_bytes] {
-        return stopped_ || buffer_.size() >= min_bytes;
-      })) {
-    return Result{ByteVec{}, ErrorCode::Timeout, 0, buffer_.size()};
+  if (view_open_) {
+    return ReadView{{}, {}, ErrorCode::ControllerStopped, 0,
+                    buffered_locked(), {}};
   }
 
-  if (stopped_) {
-    if (buffer_.empty()) {
-      return Result{ByteVec{}, ErrorCode::ControllerStopped, 0, 0};
+  merge_slabs();
+  refill_from_spill();
+  ReadView view = make_view(max_bytes, stopped_);
+  view_open_ = view.size() > 0;
+  return view;
+}
+
+void ByteStreamController::consume(size_t bytes) {
+  if (backend_ == Backend::Spsc) {
+    const size_t released = std::min(bytes, ring_.size());
+    ring_.consume(released);
+    metrics_.add_out(released);
+    wake_producers();
+    return;
+  }
+
+  bool wake = false;
+  bool resume = false;
+  {
+    const std::scoped_lock lock(mutex_);
+    size_t released = std::min(bytes, ring_.size());
+    if (framed_) {
+      released = pop_frames(released);
     }
+    ring_.consume(released);
+    metrics_.add_out(released);
+    pop_tags(released);
+    refill_from_spill();
+    view_open_ = false;
+    wake = has_sleeping_readers();
+    resume = has_async_waiters();
   }
 
-  const size_t bytes_available = buffer_.size();
-  const size_t bytes_to_take = std::min(bytes_available, max_bytes);
+  // Other readers may be waiting for the view to close.
+  if (wake) {
+    cv_.notify_all();
+  }
+  if (blocked_producers_.load(std::memory_order_relaxed) > 0) {
+    producer_cv_.notify_all();
+  }
+  if (resume) {
+    resume_async_waiters();
+  }
+}
 
-  ByteVec result;
-  result.reserve(bytes_to_take);
-  result.insert(
-      result.end(), std::make_move_iterator(buffer_.begin()),
-      std::make_move_iterator(buffer_.begin() +
-                              static_cast<std::ptrdiff_t>(bytes_to_take)));
+ByteStreamController::MessageBatch ByteStreamController::read_messages(
+    size_t max_messages, size_t max_bytes, std::chrono::milliseconds timeout) {
+  if (!framed_ || max_messages == 0) {
+    return MessageBatch{{}, {}, ErrorCode::InvalidArgs, 0,
+                        current_buffer_size()};
+  }
+
+  MessageBatch batch;
+  bool wake = false;
+  bool resume = false;
+  {
+    std::unique_lock lock(mutex_, std::defer_lock);
+    if (!wait_readable(lock, MIN_READ_SIZE, timeout)) {
+      return MessageBatch{{}, {}, ErrorCode::Timeout, 0, buffered_locked()};
+    }
+    if (view_open_) {
+      return MessageBatch{{}, {}, ErrorCode::ControllerStopped, 0,
+                          buffered_locked()};
+    }
+
+    refill_from_spill();
+    const size_t bytes =
+        frame_prefix(max_messages, std::min(max_bytes, ring_.size()));
+    if (bytes == 0) {
+      return MessageBatch{{},
+                          {},
+                          frames_.empty() ? ErrorCode::ControllerStopped
+                                          : ErrorCode::InvalidArgs,
+                          0,
+                          buffered_locked()};
+    }
+
+    const auto [first, second] = ring_.readable(bytes);
+    size_t end = 0;
+    for (auto it = frames_.begin(); end < bytes; ++it) {
+      end += *it;
+      batch.ends.push_back(end);
+    }
+
+    if (checksum_) {
+      // Copy message by message so each gets its own checksum.
+      batch.data.resize(bytes);
+      ByteSpan source = first;
+      size_t begin = 0;
+      for (const size_t message_end : batch.ends) {
+        uint32_t crc = 0;
+        while (begin < message_end) {
+          if (source.empty()) {
+            source = second;
+          }
+          const size_t chunk = std::min(message_end - begin, source.size());
+          crc = crc32c_copy(crc, batch.data.data() + begin,
+                            source.first(chunk));
+          source = source.subspan(chunk);
+          begin += chunk;
+        }
+        batch.crc32c.push_back(crc);
+      }
+    } else {
+      batch.data.reserve(bytes);
+      batch.data.insert(batch.data.end(), first.begin(), first.end());
+      batch.data.insert(batch.data.end(), second.begin(), second.end());
+    }
+
+    pop_frames(bytes);
+    ring_.consume(bytes);
+    metrics_.add_out(bytes);
+    refill_from_spill();
+
+    batch.error = stopped_ ? ErrorCode::ControllerStopped : ErrorCode::NoError;
+    batch.dropped_bytes = dropped_bytes_.exchange(0, std::memory_order_relaxed);
+    batch.buffer_size = buffered_locked();
+    wake = !ring_.empty() && has_sleeping_readers();
+    resume = has_async_waiters();
+  }
+
+  if (wake) {
+    cv_.notify_one();
+  }
+  if (blocked_producers_.load(std::memory_order_relaxed) > 0) {
+    producer_cv_.notify_all();
+  }
+  if (resume) {
+    resume_async_waiters();
+  }
+  return batch;
+}
+
+void ByteStreamController::push_frame(size_t bytes) {
+  if (framed_ && bytes > 0) {
+    frames_.push_back(bytes);
+  }
+}
+
+size_t ByteStreamController::frame_prefix(size_t max_messages,
+                                          size_t max_bytes) const {
+  size_t bytes = 0;
+  for (auto it = frames_.begin(); it != frames_.end() && max_messages > 0 &&
+                                  *it <= max_bytes - bytes;
+       ++it, --max_messages) {
+    bytes += *it;
+  }
+  return bytes;
+}
+
+size_t ByteStreamController::pop_frames(size_t bytes) {
+  size_t popped = 0;
+  while (!frames_.empty() && frames_.front() <= bytes - popped) {
+    popped += frames_.front();
+    frames_.pop_front();
+  }
+  return popped;
+}
+
+std::pmr::memory_resource* ByteStreamController::result_resource()
+    const noexcept {
+  if (result_pool_ != nullptr) {
+    return result_pool_.get();
+  }
+  return std::pmr::get_default_resource();
+}
+
+ByteStreamController::ReadView ByteStreamController::make_view(
+    size_t max_bytes, bool stopped) {
+  if (framed_) {
+    // A message may continue in the spill file; only whole ones in ring_
+    // are readable.
+    const size_t whole = frame_prefix(std::numeric_limits<size_t>::max(),
+                                      std::min(max_bytes, ring_.size()));
+    if (whole == 0 && !frames_.empty()) {
+      return ReadView{{}, {}, ErrorCode::InvalidArgs, 0, ring_.size(), {}};
+    }
+    max_bytes = whole;
+  }
+
+  const auto [first, second] = ring_.readable(max_bytes);
+  const size_t taken = first.size() + second.size();
+  const size_t dropped = dropped_bytes_.exchange(0, std::memory_order_relaxed);
+
+  // While draining an empty buffer is the end of the stream.
+  if ((stopped || draining_.load(std::memory_order_acquire)) && taken == 0) {
+    return ReadView{{}, {}, ErrorCode::ControllerStopped, dropped, 0, {}};
+  }
+
+  return ReadView{first,
+                  second,
+                  stopped ? ErrorCode::ControllerStopped : ErrorCode::NoError,
+                  dropped,
+                  buffered_locked() - taken,
+                  collect_tags(taken)};
+}
+
+size_t ByteStreamController::buffered_locked() const {
+  size_t total = ring_.size();
+  if (spill_ != nullptr) {
+    total += spill_->size();
+  }
+  for (const auto& slab : slabs_) {
+    total += slab->ring.size();
+  }
+  return total;
+}
+
+bool ByteStreamController::ring_reserved() const noexcept {
+  // The Spsc producer owns its reservation without the lock. It has no
+  // slabs or spill file that could be moved into ring_, so there is
+  // nothing to hold back.
+  return backend_ != Backend::Spsc && reserved_bytes_ > 0 &&
+         reserved_ring_ == &ring_;
+}
+
+size_t ByteStreamController::readable_locked() const {
+  return ring_reserved() ? ring_.size() : buffered_locked();
+}
+
+ByteRing& ByteStreamController::write_ring(size_t bytes) {
+  // New data goes to the spill file once ring_ is full, and keeps going
+  // there until it has been drained, so the order is preserved. A message
+  // that ring_ can never hold would never be readable whole.
+  if (spill_ == nullptr || (framed_ && bytes > ring_.capacity()) ||
+      (spill_->empty() && ring_.free_space() >= bytes)) {
+    return ring_;
+  }
+  return *spill_;
+}
+
+size_t ByteStreamController::max_write_size() const noexcept {
+  if (spill_ == nullptr || framed_) {
+    return ring_.capacity();
+  }
+  return std::max(ring_.capacity(), spill_->capacity());
+}
+
+void ByteStreamController::refill_from_spill() {
+  if (spill_ == nullptr || ring_reserved()) {
+    return;
+  }
+
+  const auto [first, second] = spill_->readable(ring_.free_space());
+  ring_.try_push(first);
+  ring_.try_push(second);
+  spill_->consume(first.size() + second.size());
+}
+
+void ByteStreamController::merge_slabs() {
+  // Everything in ring_ that is not tagged yet came from async_add_data(),
+  // also once every slab has been retired.
+  tag_untagged();
+  // Merged bytes would land in the reserved region; they wait for commit().
+  if (slabs_.empty() || ring_reserved()) {
+    return;
+  }
+
+  // Start at a different slab each time so no producer is starved.
+  const size_t count = slabs_.size();
+  size_t free_space = ring_.free_space();
+  bool merged = false;
+  for (size_t i = 0; i < count && free_space > 0; ++i) {
+    ProducerSlab& slab = *slabs_[(merge_cursor_ + i) % count];
+    const auto [first, second] = slab.ring.readable(free_space);
+    const size_t moved = first.size() + second.size();
+    if (moved == 0) {
+      continue;
+    }
+
+    staged_bytes_.fetch_sub(static_cast<int64_t>(moved),
+                            std::memory_order_relaxed);
+    ring_.try_push(first);
+    ring_.try_push(second);
+    slab.ring.consume(moved);
+    tag_bytes(slab.id, moved);
+    free_space -= moved;
+    merged = true;
+  }
+  merge_cursor_ = (merge_cursor_ + 1) % count;
+  metrics_.observe_size(buffered_locked());
+
+  std::erase_if(slabs_, [](const std::unique_ptr<ProducerSlab>& slab) {
+    return slab->retired.load(std::memory_order_acquire) &&
+           slab->ring.empty();
+  });
+
+  // The lock is held, so a producer is either registered or will see the
+  // new space before parking.
+  if (merged && blocked_producers_.load(std::memory_order_relaxed) > 0) {
+    producer_cv_.notify_all();
+  }
+}
+
+void ByteStreamController::tag_bytes(uint32_t producer_id, size_t bytes) {
+  if (!tag_producers_ || bytes == 0) {
+    return;
+  }
+
+  if (!tags_.empty() && tags_.back().producer_id == producer_id) {
+    tags_.back().size += bytes;
+  } else {
+    tags_.push_back(ProducerChunk{producer_id, bytes});
+  }
+  tagged_bytes_ += bytes;
+}
 
-  buffer_.erase(buffer_.begin(),
-                buffer_.begin() + static_cast<std::ptrdiff_t>(bytes_to_take));
+void ByteStreamController::tag_untagged() {
+  if (tag_producers_) {
+    tag_bytes(0, ring_.size() - tagged_bytes_);
+  }
+}
 
-  return Result{std::move(result),
-                stopped_ ? ErrorCode::ControllerStopped : ErrorCode::NoError,
-                bytes_to_take, buffer_.size()};
+void ByteStreamController::pop_tags(size_t bytes) {
+  // Untagged bytes always follow the tagged ones, so the oldest bytes are
+  // covered by the front of tags_ as long as there is one.
+  while (bytes > 0 && !tags_.empty()) {
+    ProducerChunk& front = tags_.front();
+    const size_t taken = std::min(bytes, front.size);
+    front.size -= taken;
+    tagged_bytes_ -= taken;
+    bytes -= taken;
+    if (front.size == 0) {
+      tags_.pop_front();
+    }
+  }
+}
+
+std::vector<ByteStreamController::ProducerChunk>
+ByteStreamController::collect_tags(size_t bytes) const {
+  std::vector<ProducerChunk> chunks;
+  for (auto it = tags_.begin(); bytes > 0 && it != tags_.end(); ++it) {
+    const size_t taken = std::min(bytes, it->size);
+    chunks.push_back(ProducerChunk{it->producer_id, taken});
+    bytes -= taken;
+  }
+  return chunks;
+}
+
+ByteStreamController::ErrorCode ByteStreamController::push_lock_free(
+    ByteRing& ring, ByteSpan data) {
+  bool pushed = ring.try_push(data);
+  if (!pushed && overflow_policy_ == OverflowPolicy::Block &&
+      spsc_wait_space(ring, data.size())) {
+    pushed = ring.try_push(data);
+  }
+
+  if (!pushed && overflow_policy_ == OverflowPolicy::Block && !accepting()) {
+    // Gave up waiting for space because producers were fenced off.
+    return ErrorCode::ControllerStopped;
+  }
+
+  size_t accepted = data.size();
+  if (pushed) {
+    metrics_.add_in(data.size());
+  } else if (truncates_on_overflow()) {
+    // The producer cannot evict under a lock-free reader, so DropOldest
+    // truncates the new data like DropNewest.
+    accepted = push_prefix(ring, data);
+  } else {
+    metrics_.add_dropped(rejection_reason(), data.size());
+    return ErrorCode::BufferOverflow;
+  }
+
+  if (&ring == &ring_) {
+    metrics_.observe_size(ring_.size());
+  } else {
+    // ring_ is read first: a merge takes bytes off staged_bytes_ before
+    // moving them, so no byte is counted twice.
+    const size_t merged = ring_.size();
+    const int64_t staged =
+        staged_bytes_.fetch_add(static_cast<int64_t>(accepted),
+                                std::memory_order_relaxed) +
+        static_cast<int64_t>(accepted);
+    metrics_.observe_size(merged +
+                          static_cast<size_t>(std::max<int64_t>(staged, 0)));
+  }
+
+  wake_reader();
+  return ErrorCode::NoError;
+}
+
+void ByteStreamController::wake_reader() {
+  // Pairs with the fence in spsc_wait and ReadAwaitable::await_suspend:
+  // either the reader sees the new head before sleeping, or we see it
+  // registered and wake it up.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping_readers_.load(std::memory_order_relaxed) > 0) {
+    { const std::scoped_lock lock(mutex_); }
+    cv_.notify_one();
+  }
+  if (async_waiter_count_.load(std::memory_order_relaxed) > 0) {
+    resume_async_waiters();
+  }
+}
+
+bool ByteStreamController::spsc_wait(size_t min_bytes,
+                                     std::chrono::milliseconds timeout) {
+  auto ready = [this, min_bytes] {
+    return readers_released() || ring_.size() >= min_bytes;
+  };
+
+  if (ready() || poll_until(wait_strategy_, ready)) {
+    return true;
+  }
+
+  std::unique_lock lock(mutex_);
+  sleeping_readers_.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const bool woken = cv_.wait_for(lock, timeout, ready);
+  sleeping_readers_.fetch_sub(1, std::memory_order_relaxed);
+  return woken;
+}
+
+bool ByteStreamController::has_sleeping_readers() const noexcept {
+  // Readers register under the mutex before they test for data, so with the
+  // lock held this count is exact.
+  return sleeping_readers_.load(std::memory_order_relaxed) > 0;
+}
+
+bool ByteStreamController::has_async_waiters() const noexcept {
+  return async_waiter_count_.load(std::memory_order_relaxed) > 0;
+}
+
+void ByteStreamController::wake_producers() {
+  // Same handshake as wake_reader, in the other direction.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (blocked_producers_.load(std::memory_order_relaxed) > 0) {
+    { const std::scoped_lock lock(mutex_); }
+    producer_cv_.notify_all();
+  }
+}
+
+bool ByteStreamController::spsc_wait_space(const ByteRing& ring,
+                                           size_t bytes) {
+  if (bytes > ring.capacity()) {
+    return false;
+  }
+
+  auto ready = [this, &ring, bytes] {
+    return !accepting() || ring.free_space() >= bytes;
+  };
+
+  if (!ready()) {
+    std::unique_lock lock(mutex_);
+    blocked_producers_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    producer_cv_.wait_for(lock, block_timeout_, ready);
+    blocked_producers_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  return accepting();
+}
+
+ByteStreamController::ReadAwaitable ByteStreamController::async_get_data(
+    size_t min_bytes, size_t max_bytes, std::chrono::milliseconds timeout) {
+  return ReadAwaitable(this, min_bytes, max_bytes,
+                       std::chrono::steady_clock::now() + timeout);
+}
+
+ByteStreamController::ReadAwaitable::ReadAwaitable(
+    ByteStreamController* controller, size_t min_bytes, size_t max_bytes,
+    std::chrono::steady_clock::time_point deadline) noexcept
+    : controller_(controller),
+      min_bytes_(min_bytes),
+      max_bytes_(max_bytes),
+      deadline_(deadline) {}
+
+bool ByteStreamController::ReadAwaitable::await_ready() const {
+  return min_bytes_ > max_bytes_ || controller_->readers_released() ||
+         controller_->current_buffer_size() >= min_bytes_;
+}
+
+bool ByteStreamController::ReadAwaitable::await_suspend(
+    std::coroutine_handle<> handle) {
+  handle_ = handle;
+
+  const std::scoped_lock lock(controller_->mutex_);
+  controller_->async_waiters_.push_back(this);
+  controller_->async_waiter_count_.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  // Recheck after registering so that a producer which has already looked
+  // at the waiter count cannot leave us suspended.
+  if (controller_->readers_released() ||
+      controller_->readable_locked() >= min_bytes_) {
+    controller_->async_waiters_.pop_back();
+    controller_->async_waiter_count_.fetch_sub(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+ByteStreamController::Result ByteStreamController::ReadAwaitable::
+    await_resume() {
+  if (!completed_) {
+    result_ = controller_->sync_get_data(min_bytes_, max_bytes_,
+                                         std::chrono::milliseconds::zero());
+  }
+  return std::move(result_);
+}
+
+void ByteStreamController::resume_async_waiters() {
+  for (;;) {
+    ReadAwaitable* waiter = nullptr;
+    {
+      const std::scoped_lock lock(mutex_);
+      const size_t readable = readable_locked();
+      const auto it = std::ranges::find_if(
+          async_waiters_, [this, readable](const ReadAwaitable* candidate) {
+            return readers_released() || readable >= candidate->min_bytes_;
+          });
+      if (it == async_waiters_.end()) {
+        return;
+      }
+      waiter = *it;
+      async_waiters_.erase(it);
+      async_waiter_count_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    Result result = sync_get_data(waiter->min_bytes_, waiter->max_bytes_,
+                                  std::chrono::milliseconds::zero());
+    if (result.error == ErrorCode::Timeout) {
+      // Another reader took the data first; keep waiting.
+      const std::scoped_lock lock(mutex_);
+      async_waiters_.push_back(waiter);
+      async_waiter_count_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    waiter->result_ = std::move(result);
+    waiter->completed_ = true;
+    waiter->handle_.resume();
+  }
+}
+
+size_t ByteStreamController::process_async_timeouts(
+    std::chrono::steady_clock::time_point now) {
+  std::vector<ReadAwaitable*> expired;
+  {
+    const std::scoped_lock lock(mutex_);
+    const auto removed =
+        std::ranges::partition(async_waiters_, [now](const ReadAwaitable* w) {
+          return w->deadline_ > now;
+        });
+    expired.assign(removed.begin(), removed.end());
+    async_waiters_.erase(removed.begin(), removed.end());
+    async_waiter_count_.fetch_sub(expired.size(), std::memory_order_relaxed);
+
+    for (ReadAwaitable* waiter : expired) {
+      metrics_.add_read_timeout();
+      waiter->result_ =
+          Result{ByteVec{}, ErrorCode::Timeout, 0, buffered_locked(), {}};
+      waiter->completed_ = true;
+    }
+  }
+
+  for (ReadAwaitable* waiter : expired) {
+    waiter->handle_.resume();
+  }
+  return expired.size();
 }
 
 size_t ByteStreamController::current_buffer_size() const {
+  if (backend_ == Backend::Sharded || spill_ != nullptr) {
+    const std::scoped_lock lock(mutex_);
+    return buffered_locked();
+  }
+  return ring_.size();
+}
+
+size_t ByteStreamController::spilled_bytes() const {
+  if (spill_ == nullptr) {
+    return 0;
+  }
   const std::scoped_lock lock(mutex_);
-  return buffer_.size();
+  return spill_->size();
 }
 
 bool ByteStreamController::is_stopped() const {
   return stopped_.load(std::memory_order_relaxed);
 }
 
+void ByteStreamController::record_read(
+    std::chrono::steady_clock::time_point wait_start, bool ready) noexcept {
+  metrics_.add_read(std::chrono::steady_clock::now() - wait_start);
+  if (!ready) {
+    metrics_.add_read_timeout();
+  }
+}
+
+ByteStreamController::MetricsSnapshot ByteStreamController::metrics()
+    const noexcept {
+  return metrics_.snapshot();
+}
+
 ByteStreamController::Callback ByteStreamController::get_callback() {
-  return [this](ByteSpan data) { async_add_data(data); };
+  return [this](ByteSpan data) {
+    if (async_add_data(data) != ErrorCode::NoError) {
+      record_drop(data.size());
+    }
+  };
 }
\ No newline at end of file
@@ -0,0 +1,247 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <latch>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "../include/async_controller.hpp"
+
+using Controller = ByteStreamController;
+using Clock = std::chrono::steady_clock;
+
+// Bytes moved through the controller in one benchmark iteration.
+static constexpr size_t kBytesPerIteration = size_t{4} << 20;
+// Every chunk starts with the steady_clock time at which it was produced.
+static constexpr size_t kStampSize = sizeof(int64_t);
+static constexpr std::chrono::milliseconds kReadTimeout{100};
+
+// Benchmark arguments, in order.
+enum Arg : uint8_t {
+  kBackend,
+  kProducers,
+  kChunk,
+  kBuffer,
+  kMinBytes,
+  kMaxBytes,  // 0 means unlimited
+  kSpin,      // spin_count; yield_count is the same value
+};
+
+static size_t arg(const benchmark::State& state, Arg index) {
+  return static_cast<size_t>(state.range(index));
+}
+
+static int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Clock::now().time_since_epoch())
+      .count();
+}
+
+// Reassembles the chunk stamps from the received byte stream. Only valid
+// while chunks are never split by other producers' data, see stamped().
+class LatencyRecorder {
+ public:
+  LatencyRecorder(size_t chunk, std::vector<int64_t>& samples)
+      : chunk_(chunk), samples_(samples) {}
+
+  void feed(Controller::ByteSpan data) {
+    size_t pos = 0;
+    while (pos < data.size()) {
+      const size_t in_chunk = offset_ % chunk_;
+      size_t step = 0;
+      if (in_chunk < kStampSize) {
+        step = std::min(kStampSize - in_chunk, data.size() - pos);
+        std::memcpy(stamp_.data() + in_chunk, data.data() + pos, step);
+      } else {
+        step = std::min(chunk_ - in_chunk, data.size() - pos);
+      }
+      pos += step;
+      offset_ += step;
+
+      if (offset_ % chunk_ == 0) {
+        int64_t produced = 0;
+        std::memcpy(&produced, stamp_.data(), kStampSize);
+        samples_.push_back(now_ns() - produced);
+      }
+    }
+  }
+
+ private:
+  size_t chunk_;
+  size_t offset_ = 0;
+  std::array<std::byte, kStampSize> stamp_{};
+  std::vector<int64_t>& samples_;
+};
+
+// Chunks stay contiguous unless several Sharded slabs are merged.
+static bool stamped(Controller::Backend backend, size_t producers) {
+  return backend != Controller::Backend::Sharded || producers == 1;
+}
+
+static void produce(Controller& controller, Controller::Producer* handle,
+                    size_t chunk, size_t chunks) {
+  std::vector<std::byte> buffer(chunk, std::byte{0x5a});
+  for (size_t i = 0; i < chunks; ++i) {
+    const int64_t stamp = now_ns();
+    std::memcpy(buffer.data(), &stamp, kStampSize);
+
+    // Block makes the producer wait for space; retry if that times out.
+    Controller::ErrorCode error = Controller::ErrorCode::BufferOverflow;
+    while (error == Controller::ErrorCode::BufferOverflow) {
+      error = handle != nullptr ? handle->add_data(buffer)
+                                : controller.async_add_data(buffer);
+    }
+    if (error != Controller::ErrorCode::NoError) {
+      return;
+    }
+  }
+}
+
+static double percentile(std::vector<int64_t>& samples, double rank) {
+  if (samples.empty()) {
+    return 0.0;
+  }
+  const auto index = static_cast<size_t>(
+      std::ceil(rank * static_cast<double>(samples.size() - 1)));
+  std::ranges::nth_element(samples, samples.begin() +
+                                        static_cast<std::ptrdiff_t>(index));
+  return static_cast<double>(samples[index]);
+}
+
+static void BM_Stream(benchmark::State& state) {
+  const auto backend = static_cast<Controller::Backend>(arg(state, kBackend));
+  const size_t producers = arg(state, kProducers);
+  const size_t chunk = arg(state, kChunk);
+  const size_t min_bytes = arg(state, kMinBytes);
+  const size_t max_bytes = arg(state, kMaxBytes) == 0
+                               ? std::numeric_limits<size_t>::max()
+                               : arg(state, kMaxBytes);
+  const auto spin = static_cast<uint32_t>(arg(state, kSpin));
+  const size_t chunks = kBytesPerIteration / chunk / producers;
+  const size_t total = chunks * chunk * producers;
+
+  Controller::Options options;
+  options.max_buffer_size = arg(state, kBuffer);
+  options.backend = backend;
+  options.overflow_policy = Controller::OverflowPolicy::Block;
+  options.producer_slab_size = arg(state, kBuffer);
+  options.wait_strategy = Controller::WaitStrategy{spin, spin};
+
+  std::vector<int64_t> samples;
+  size_t reads = 0;
+
+  for (auto _ : state) {
+    Controller controller(options);
+    std::vector<Controller::Producer> handles;
+    if (backend == Controller::Backend::Sharded) {
+      for (size_t i = 0; i < producers; ++i) {
+        handles.push_back(controller.register_producer());
+      }
+    }
+
+    std::latch ready(static_cast<std::ptrdiff_t>(producers) + 1);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < producers; ++i) {
+      Controller::Producer* handle = handles.empty() ? nullptr : &handles[i];
+      threads.emplace_back([&, handle] {
+        ready.arrive_and_wait();
+        produce(controller, handle, chunk, chunks);
+      });
+    }
+
+    LatencyRecorder latency(chunk, samples);
+    ready.arrive_and_wait();
+    const auto start = Clock::now();
+
+    size_t received = 0;
+    while (received < total) {
+      const auto result = controller.sync_get_data(
+          std::min(min_bytes, total - received), max_bytes, kReadTimeout);
+      if (result.error == Controller::ErrorCode::Timeout) {
+        continue;
+      }
+      if (!result) {
+        state.SkipWithError("read failed");
+        break;
+      }
+      if (stamped(backend, producers)) {
+        latency.feed(result.data);
+      }
+      received += result.data.size();
+      ++reads;
+    }
+
+    state.SetIterationTime(
+        std::chrono::duration<double>(Clock::now() - start).count());
+    controller.stop();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  const int64_t iterations = state.iterations();
+  state.SetBytesProcessed(iterations * static_cast<int64_t>(total));
+  state.SetItemsProcessed(iterations *
+                          static_cast<int64_t>(chunks * producers));
+  state.counters["reads/s"] = benchmark::Counter(
+      static_cast<double>(reads), benchmark::Counter::kIsRate);
+  if (!samples.empty()) {
+    state.counters["p50_ns"] = percentile(samples, 0.50);
+    state.counters["p99_ns"] = percentile(samples, 0.99);
+    state.counters["p999_ns"] = percentile(samples, 0.999);
+  }
+}
+
+// Sweeps one parameter at a time around a baseline for every backend so
+// the run stays short enough to compare backends side by side.
+static void stream_args(benchmark::internal::Benchmark* bench) {
+  bench->ArgNames({"backend", "producers", "chunk", "buffer", "min_bytes",
+                   "max_bytes", "spin"});
+
+  constexpr int64_t kChunkBase = 1024;
+  constexpr auto kBufferBase =
+      static_cast<int64_t>(Controller::DEFAULT_BUFFER_SIZE);
+  constexpr auto kReadBase =
+      static_cast<int64_t>(Controller::DEFAULT_READ_SIZE);
+
+  for (const auto backend :
+       {Controller::Backend::Mutex, Controller::Backend::Spsc,
+        Controller::Backend::Sharded}) {
+    const auto id = static_cast<int64_t>(backend);
+    const bool spsc = backend == Controller::Backend::Spsc;
+
+    bench->Args({id, 1, kChunkBase, kBufferBase, 1, kReadBase, 0});
+    if (!spsc) {
+      for (const int64_t producers : {2, 4}) {
+        bench->Args({id, producers, kChunkBase, kBufferBase, 1, kReadBase, 0});
+      }
+    }
+    for (const int64_t chunk : {64, 256, 4096}) {
+      bench->Args({id, 1, chunk, kBufferBase, 1, kReadBase, 0});
+    }
+    for (const int64_t buffer : {int64_t{1} << 14, int64_t{1} << 16}) {
+      bench->Args({id, 1, kChunkBase, buffer, 1, kReadBase, 0});
+    }
+    for (const int64_t min_bytes : {int64_t{64}, kReadBase}) {
+      bench->Args({id, 1, kChunkBase, kBufferBase, min_bytes, kReadBase, 0});
+    }
+    for (const int64_t max_bytes : {int64_t{64}, int64_t{0}}) {
+      bench->Args({id, 1, kChunkBase, kBufferBase, 1, max_bytes, 0});
+    }
+    bench->Args({id, 1, kChunkBase, kBufferBase, 1, kReadBase, 1000});
+  }
+}
+
+BENCHMARK(BM_Stream)
+    ->Apply(stream_args)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,677 @@
+// The checks must also run in release builds, which define NDEBUG.
+#undef NDEBUG
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../include/async_controller.hpp"
+#include "../include/broadcast_stream.hpp"
+#include "../include/crc32c.hpp"
+
+namespace {
+
+using Controller = ByteStreamController;
+using ErrorCode = Controller::ErrorCode;
+using DropReason = Controller::DropReason;
+using LagPolicy = BroadcastStream::LagPolicy;
+
+constexpr size_t SMALL_BUFFER_SIZE = 8;
+constexpr size_t RING_BUFFER_SIZE = 16;
+constexpr std::chrono::milliseconds NO_WAIT{0};
+constexpr std::chrono::milliseconds SHORT_WAIT{20};
+constexpr std::chrono::seconds LONG_WAIT{5};
+
+std::vector<std::byte> bytes(std::string_view text) {
+  std::vector<std::byte> result;
+  result.reserve(text.size());
+  for (const char c : text) {
+    result.push_back(static_cast<std::byte>(c));
+  }
+  return result;
+}
+
+std::string text(std::span<const std::byte> data) {
+  std::string result;
+  result.reserve(data.size());
+  for (const std::byte b : data) {
+    result.push_back(static_cast<char>(b));
+  }
+  return result;
+}
+
+Controller::Options options(Controller::Backend backend, size_t size) {
+  Controller::Options result;
+  result.backend = backend;
+  result.max_buffer_size = size;
+  return result;
+}
+
+// Coroutine that starts right away and cleans up after itself.
+struct Task {
+  struct promise_type {
+    Task get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+// GCC 12 warns about a null pointer in its own coroutine frame code.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wzero-as-null-pointer-constant"
+#endif
+// Appends one async_get_data() read to the output and counts it.
+Task read_async(Controller& controller, size_t min_bytes, std::string& out,
+                std::atomic<size_t>& completed) {
+  const auto read = co_await controller.async_get_data(min_bytes, SIZE_MAX,
+                                                       LONG_WAIT);
+  out += text(read.data);
+  completed.fetch_add(1, std::memory_order_release);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// Reads everything buffered without waiting.
+std::string drain(Controller& controller) {
+  std::string result;
+  for (;;) {
+    const auto read = controller.sync_get_data(1, SIZE_MAX, NO_WAIT);
+    if (read.data.empty()) {
+      return result;
+    }
+    result += text(read.data);
+  }
+}
+
+BroadcastStream::Options broadcast_options(LagPolicy policy, size_t max_lag) {
+  BroadcastStream::Options result;
+  result.max_buffer_size = RING_BUFFER_SIZE;
+  result.max_lag = max_lag;
+  result.lag_policy = policy;
+  result.block_timeout = LONG_WAIT;
+  return result;
+}
+
+}  // namespace
+
+void runTests() {
+  // Test 1
+  for (const auto backend :
+       {Controller::Backend::Mutex, Controller::Backend::Spsc,
+        Controller::Backend::Sharded}) {
+    Controller controller(options(backend, RING_BUFFER_SIZE));
+    assert(controller.backend() == backend);
+    auto producer = controller.register_producer();
+    const auto first = bytes("abc");
+    const auto second = bytes("defg");
+    const auto error1 = producer.add_data(first);
+    const auto error2 = producer.add_data(second);
+    assert(error1 == ErrorCode::NoError && error2 == ErrorCode::NoError);
+    assert(controller.current_buffer_size() == 7);
+
+    const auto read1 = controller.sync_get_data(2, 2, NO_WAIT);
+    assert(read1 && text(read1.data) == "ab" && read1.buffer_size == 5);
+    const auto read2 = controller.sync_get_data(1, SIZE_MAX, NO_WAIT);
+    assert(read2 && text(read2.data) == "cdefg" && read2.buffer_size == 0);
+    const auto read3 = controller.sync_get_data(1, SIZE_MAX, NO_WAIT);
+    assert(read3.error == ErrorCode::Timeout && read3.data.empty());
+
+    const auto metrics = controller.metrics();
+    assert(metrics.bytes_in == 7 && metrics.bytes_out == 7);
+    assert(metrics.read_timeouts == 1 && metrics.high_water_mark >= 7);
+  }
+
+  // Test 2
+  {
+    Controller controller(
+        options(Controller::Backend::Mutex, RING_BUFFER_SIZE));
+    const auto head = bytes("0123456789");
+    const auto error1 = controller.async_add_data(head);
+    assert(error1 == ErrorCode::NoError);
+    assert(drain(controller) == "0123456789");
+
+    // The ring now wraps after six bytes.
+    const auto wrapped = bytes("abcdefghijkl");
+    const auto error2 = controller.async_add_data(wrapped);
+    assert(error2 == ErrorCode::NoError);
+    const auto view = controller.read_view(1, SIZE_MAX, NO_WAIT);
+    assert(view && view.first.size() == 6 && view.second.size() == 6);
+    assert(text(view.first) + text(view.second) == "abcdefghijkl");
+    controller.consume(view.size());
+
+    // A reservation across the end is staged and copied in on commit.
+    const auto span = controller.reserve(12);
+    assert(span.size() == 12);
+    const auto payload = bytes("ABCDEFGHIJKL");
+    std::ranges::copy(payload, span.begin());
+    const auto error3 = controller.commit(span.size());
+    assert(error3 == ErrorCode::NoError);
+    assert(drain(controller) == "ABCDEFGHIJKL");
+  }
+
+  // Test 3
+  for (const auto backend :
+       {Controller::Backend::Mutex, Controller::Backend::Spsc,
+        Controller::Backend::Sharded}) {
+    Controller controller(options(backend, SMALL_BUFFER_SIZE));
+    auto span = controller.reserve(4);
+    assert(span.size() == 4);
+    std::ranges::copy(bytes("wxyz"), span.begin());
+    const auto error1 = controller.commit(2);
+    assert(error1 == ErrorCode::NoError);
+
+    span = controller.reserve(3);
+    assert(span.size() == 3);
+    const auto error2 = controller.commit(0);
+    assert(error2 == ErrorCode::NoError);
+    assert(drain(controller) == "wx");
+
+    const auto too_large = controller.reserve(SMALL_BUFFER_SIZE + 1);
+    assert(too_large.empty());
+    const auto metrics = controller.metrics();
+    assert(metrics.dropped(DropReason::Rejected) == SMALL_BUFFER_SIZE + 1);
+    assert(metrics.bytes_in == 2);
+  }
+
+  // Test 4
+  {
+    const auto old_data = bytes("aaaaaa");
+    const auto new_data = bytes("bbbb");
+
+    auto policy_options = [](Controller::OverflowPolicy policy) {
+      auto result = options(Controller::Backend::Mutex, SMALL_BUFFER_SIZE);
+      result.overflow_policy = policy;
+      result.block_timeout = SHORT_WAIT;
+      return result;
+    };
+
+    Controller reject(policy_options(Controller::OverflowPolicy::Reject));
+    const auto reject1 = reject.async_add_data(old_data);
+    const auto reject2 = reject.async_add_data(new_data);
+    assert(reject1 == ErrorCode::NoError);
+    assert(reject2 == ErrorCode::BufferOverflow);
+    assert(reject.metrics().dropped(DropReason::Rejected) == 4);
+    const auto rejected = reject.sync_get_data(1, SIZE_MAX, NO_WAIT);
+    assert(text(rejected.data) == "aaaaaa" && rejected.dropped_bytes == 0);
+
+    Controller oldest(policy_options(Controller::OverflowPolicy::DropOldest));
+    const auto oldest1 = oldest.async_add_data(old_data);
+    const auto oldest2 = oldest.async_add_data(new_data);
+    assert(oldest1 == ErrorCode::NoError && oldest2 == ErrorCode::NoError);
+    assert(oldest.metrics().dropped(DropReason::Evicted) == 2);
+    const auto evicted = oldest.sync_get_data(1, SIZE_MAX, NO_WAIT);
+    assert(text(evicted.data) == "aaaabbbb" && evicted.dropped_bytes == 2);
+
+    Controller newest(policy_options(Controller::OverflowPolicy::DropNewest));
+    const auto newest1 = newest.async_add_data(old_data);
+    const auto newest2 = newest.async_add_data(new_data);
+    assert(newest1 == ErrorCode::NoError && newest2 == ErrorCode::NoError);
+    assert(newest.metrics().dropped(DropReason::Truncated) == 2);
+    const auto truncated = newest.sync_get_data(1, SIZE_MAX, NO_WAIT);
+    assert(text(truncated.data) == "aaaaaabb" && truncated.dropped_bytes == 2);
+
+    Controller block(policy_options(Controller::OverflowPolicy::Block));
+    const auto block1 = block.async_add_data(old_data);
+    const auto block2 = block.async_add_data(new_data);
+    assert(block1 == ErrorCode::NoError);
+    assert(block2 == ErrorCode::BufferOverflow);
+    assert(block.metrics().dropped(DropReason::BlockTimeout) == 4);
+
+    // A blocked producer continues once a reader makes room.
+    auto waiting = policy_options(Controller::OverflowPolicy::Block);
+    waiting.block_timeout = LONG_WAIT;
+    Controller unblock(waiting);
+    const auto unblock1 = unblock.async_add_data(old_data);
+    assert(unblock1 == ErrorCode::NoError);
+    std::thread reader([&unblock] {
+      std::this_thread::sleep_for(SHORT_WAIT);
+      const auto read = unblock.sync_get_data(6, 6, LONG_WAIT);
+      assert(text(read.data) == "aaaaaa");
+    });
+    const auto unblock2 = unblock.async_add_data(new_data);
+    reader.join();
+    assert(unblock2 == ErrorCode::NoError);
+    assert(drain(unblock) == "bbbb");
+    assert(unblock.metrics().dropped(DropReason::BlockTimeout) == 0);
+  }
+
+  // Test 5
+  {
+    auto framed_options =
+        options(Controller::Backend::Mutex, RING_BUFFER_SIZE);
+    framed_options.framed = true;
+    Controller controller(framed_options);
+    for (const std::string_view message : {"ab", "cde", "fghi"}) {
+      const auto error = controller.async_add_data(bytes(message));
+      assert(error == ErrorCode::NoError);
+    }
+
+    const auto batch = controller.read_messages(2);
+    assert(batch && batch.count() == 2);
+    assert(text(batch.message(0)) == "ab" && text(batch.message(1)) == "cde");
+    assert(batch.buffer_size == 4);
+
+    // Reads never tear a message.
+    const auto torn = controller.sync_get_data(1, 3, NO_WAIT);
+    assert(torn.error == ErrorCode::InvalidArgs && torn.data.empty());
+    const auto whole = controller.sync_get_data(1, SIZE_MAX, NO_WAIT);
+    assert(whole && text(whole.data) == "fghi");
+
+    // A message that does not fit is dropped whole.
+    const auto large = bytes("0123456789abcdef");
+    const auto small = bytes("0123456789");
+    const auto error1 = controller.async_add_data(small);
+    const auto error2 = controller.async_add_data(large);
+    assert(error1 == ErrorCode::NoError);
+    assert(error2 == ErrorCode::BufferOverflow);
+    const auto rest = controller.read_messages(SIZE_MAX, SIZE_MAX, NO_WAIT);
+    assert(rest.count() == 1 && text(rest.message(0)) == "0123456789");
+  }
+
+  // Test 6
+  {
+    auto spill_options = options(Controller::Backend::Mutex, RING_BUFFER_SIZE);
+    spill_options.spill_path =
+        std::filesystem::temp_directory_path() / "async_controller_tests.spill";
+    spill_options.spill_capacity = 4096;
+    Controller controller(spill_options);
+    assert(!controller.spill_error());
+
+    std::string expected;
+    for (char c = 'a'; c <= 'z'; ++c) {
+      const std::string chunk(7, c);
+      const auto error = controller.async_add_data(bytes(chunk));
+      assert(error == ErrorCode::NoError);
+      expected += chunk;
+    }
+    assert(controller.current_buffer_size() == expected.size());
+    assert(controller.spilled_bytes() > 0);
+
+    std::string received;
+    for (;;) {
+      const auto read = controller.sync_get_data(1, 5, NO_WAIT);
+      if (read.data.empty()) {
+        break;
+      }
+      received += text(read.data);
+    }
+    assert(received == expected && controller.spilled_bytes() == 0);
+  }
+
+  // Test 7
+  {
+    const auto check = bytes("123456789");
+    constexpr uint32_t CHECK_CRC = 0xE3069283;
+    assert(crc32c_extend(0, check) == CHECK_CRC);
+    const uint32_t head = crc32c_extend(0, std::span(check).first(4));
+    assert(crc32c_extend(head, std::span(check).subspan(4)) == CHECK_CRC);
+
+    std::vector<std::byte> copy(check.size());
+    assert(crc32c_copy(0, copy.data(), check) == CHECK_CRC);
+    assert(copy == check);
+
+    auto checksum_options =
+        options(Controller::Backend::Mutex, RING_BUFFER_SIZE);
+    checksum_options.checksum = true;
+    Controller controller(checksum_options);
+    const auto error = controller.async_add_data(check);
+    assert(error == ErrorCode::NoError);
+    const auto read = controller.sync_get_data(1, SIZE_MAX, NO_WAIT);
+    assert(text(read.data) == "123456789" && read.crc32c == CHECK_CRC);
+  }
+
+  // Test 8
+  for (const auto backend :
+       {Controller::Backend::Mutex, Controller::Backend::Spsc,
+        Controller::Backend::Sharded}) {
+    Controller controller(options(backend, RING_BUFFER_SIZE));
+    const auto error1 = controller.async_add_data(bytes("0123456789"));
+    assert(error1 == ErrorCode::NoError);
+
+    // The reader waits for more than is buffered until the drain starts.
+    std::string received;
+    std::thread reader([&controller, &received] {
+      for (;;) {
+        const auto read = controller.sync_get_data(RING_BUFFER_SIZE,
+                                                   SIZE_MAX, LONG_WAIT);
+        received += text(read.data);
+        if (read.error == ErrorCode::ControllerStopped) {
+          return;
+        }
+      }
+    });
+    const auto drained = controller.close_and_drain(
+        std::chrono::steady_clock::now() + LONG_WAIT);
+    reader.join();
+    assert(drained && drained.flushed_bytes == 10);
+    assert(drained.discarded_bytes == 0 && received == "0123456789");
+    assert(controller.is_stopped());
+    const auto error2 = controller.async_add_data(bytes("late"));
+    assert(error2 == ErrorCode::ControllerStopped);
+
+    // Without a reader the deadline discards what is left.
+    controller.start();
+    const auto error3 = controller.async_add_data(bytes("left"));
+    assert(error3 == ErrorCode::NoError);
+    const auto timed_out = controller.close_and_drain(
+        std::chrono::steady_clock::now() + SHORT_WAIT);
+    assert(timed_out.error == ErrorCode::Timeout);
+    assert(timed_out.flushed_bytes == 0 && timed_out.discarded_bytes == 4);
+  }
+
+  // Test 9
+  {
+    Controller controller(
+        options(Controller::Backend::Sharded, RING_BUFFER_SIZE));
+    auto producer = controller.register_producer();
+    const auto span = controller.reserve(4);
+    assert(span.size() == 4);
+    std::ranges::copy(bytes("RRRR"), span.begin());
+
+    // Slab data is not merged over the open reservation.
+    const auto staged = bytes("SSSS");
+    const auto error1 = producer.add_data(staged);
+    assert(error1 == ErrorCode::NoError);
+    const auto early = controller.sync_get_data(1, SIZE_MAX, NO_WAIT);
+    assert(early.error == ErrorCode::Timeout && early.data.empty());
+
+    const auto error2 = controller.commit(span.size());
+    assert(error2 == ErrorCode::NoError);
+    assert(drain(controller) == "RRRRSSSS");
+  }
+
+  // Test 10
+  {
+    // The size seen by a third thread stays within the capacity.
+    constexpr size_t ROUNDS = 20000;
+    Controller controller(options(Controller::Backend::Mutex, 1024));
+    const auto chunk = bytes("0123456789abcdef");
+    std::atomic<bool> done{false};
+    std::thread producer([&controller, &chunk, &done] {
+      for (size_t i = 0; i < ROUNDS; ++i) {
+        (void)controller.async_add_data(chunk);
+      }
+      done = true;
+    });
+    std::thread reader([&controller, &done] {
+      while (!done || controller.current_buffer_size() > 0) {
+        (void)controller.sync_get_data(1, SIZE_MAX, SHORT_WAIT);
+      }
+    });
+    size_t largest = 0;
+    while (!done) {
+      largest = std::max(largest, controller.current_buffer_size());
+    }
+    producer.join();
+    reader.join();
+    assert(largest <= 1024);
+  }
+
+  // Test 11
+  for (const auto backend :
+       {Controller::Backend::Mutex, Controller::Backend::Spsc,
+        Controller::Backend::Sharded}) {
+    Controller controller(options(backend, SMALL_BUFFER_SIZE));
+    const auto unopened = controller.commit(0);
+    assert(unopened == ErrorCode::InvalidArgs);
+
+    // An oversized commit leaves the reservation open.
+    const auto span = controller.reserve(3);
+    assert(span.size() == 3);
+    std::ranges::copy(bytes("xyz"), span.begin());
+    const auto oversized = controller.commit(4);
+    assert(oversized == ErrorCode::InvalidArgs);
+    const auto fitting = controller.commit(3);
+    assert(fitting == ErrorCode::NoError);
+    const auto repeated = controller.commit(1);
+    assert(repeated == ErrorCode::InvalidArgs);
+    assert(drain(controller) == "xyz");
+
+    // The controller still accepts data and drains cleanly.
+    const auto error = controller.async_add_data(bytes("ok"));
+    assert(error == ErrorCode::NoError);
+    const auto drained = controller.close_and_drain(
+        std::chrono::steady_clock::now() + SHORT_WAIT);
+    assert(drained.error == ErrorCode::Timeout && drained.discarded_bytes == 2);
+  }
+
+  // Test 12
+  {
+    // The high-water mark covers merged and staged bytes together.
+    Controller controller(
+        options(Controller::Backend::Sharded, RING_BUFFER_SIZE));
+    auto producer = controller.register_producer();
+    const auto error1 = producer.add_data(bytes("merged"));
+    assert(error1 == ErrorCode::NoError);
+    const auto view = controller.read_view(1, 1, NO_WAIT);
+    assert(view.size() == 1);
+    controller.consume(0);
+    const auto error2 = producer.add_data(bytes("slab"));
+    assert(error2 == ErrorCode::NoError);
+    assert(controller.metrics().high_water_mark == 10);
+    assert(drain(controller) == "mergedslab");
+  }
+
+  // Test 13
+  {
+    static_assert(std::same_as<Controller::ByteVec, std::vector<std::byte>>);
+    auto pool_options = options(Controller::Backend::Mutex, RING_BUFFER_SIZE);
+    pool_options.pool_results = true;
+    Controller controller(pool_options);
+    std::pmr::memory_resource* pool = controller.result_resource();
+    assert(pool != std::pmr::get_default_resource());
+
+    Controller::PooledByteVec pooled(pool);
+    const auto error1 = controller.async_add_data(bytes("pooled"));
+    assert(error1 == ErrorCode::NoError);
+    const auto read1 = controller.sync_get_data(pooled, 1, SIZE_MAX, NO_WAIT);
+    assert(read1 && read1.size == 6 && text(pooled) == "pooled");
+    assert(pooled.get_allocator().resource() == pool);
+
+    std::vector<std::byte> plain;
+    const auto error2 = controller.async_add_data(bytes("plain"));
+    assert(error2 == ErrorCode::NoError);
+    const auto read2 = controller.sync_get_data(plain, 1, SIZE_MAX, NO_WAIT);
+    assert(read2 && text(plain) == "plain");
+
+    Controller unpooled(options(Controller::Backend::Mutex, RING_BUFFER_SIZE));
+    assert(unpooled.result_resource() == std::pmr::get_default_resource());
+  }
+
+  // Test 14
+  {
+    // A Spsc coroutine suspends while the producer holds a reservation and
+    // is resumed by the commit on the producer's thread.
+    constexpr size_t ROUNDS = 200;
+    Controller controller(options(Controller::Backend::Spsc, RING_BUFFER_SIZE));
+    const auto chunk = bytes("spsc");
+    std::atomic<size_t> launched{0};
+    std::atomic<size_t> completed{0};
+    std::string received;
+    size_t suspended = 0;
+    std::thread producer([&controller, &chunk, &launched, &completed] {
+      for (size_t round = 0; round < ROUNDS; ++round) {
+        const auto span = controller.reserve(chunk.size());
+        assert(span.size() == chunk.size());
+        std::ranges::copy(chunk, span.begin());
+        while (launched.load(std::memory_order_acquire) <= round) {
+          std::this_thread::yield();
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        const auto error = controller.commit(chunk.size());
+        assert(error == ErrorCode::NoError);
+        while (completed.load(std::memory_order_acquire) <= round) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    for (size_t round = 0; round < ROUNDS; ++round) {
+      launched.store(round + 1, std::memory_order_release);
+      read_async(controller, chunk.size(), received, completed);
+      if (completed.load(std::memory_order_acquire) <= round) {
+        ++suspended;
+      }
+      while (completed.load(std::memory_order_acquire) <= round) {
+        std::this_thread::yield();
+      }
+    }
+    producer.join();
+    assert(suspended > 0);
+    std::string expected;
+    for (size_t round = 0; round < ROUNDS; ++round) {
+      expected += "spsc";
+    }
+    assert(received == expected);
+  }
+
+  // Test 15
+  {
+    // Both consumers get every byte; the buffer follows the slower one.
+    BroadcastStream stream(RING_BUFFER_SIZE);
+    auto fast = stream.subscribe();
+    auto slow = stream.subscribe();
+    assert(stream.consumer_count() == 2);
+    const auto error1 = stream.add_data(bytes("0123456789ab"));
+    assert(error1 == ErrorCode::NoError);
+    const auto read1 = fast.read(1, SIZE_MAX, NO_WAIT);
+    assert(read1 && text(read1.data) == "0123456789ab");
+    assert(stream.current_buffer_size() == 12);
+    const auto read2 = slow.read(1, SIZE_MAX, NO_WAIT);
+    assert(read2 && text(read2.data) == "0123456789ab");
+    assert(stream.current_buffer_size() == 0);
+
+    // The next add wraps around the end of the storage.
+    const auto error2 = stream.add_data(bytes("cdefghij"));
+    assert(error2 == ErrorCode::NoError);
+    const auto read3 = fast.read(1, SIZE_MAX, NO_WAIT);
+    assert(read3 && text(read3.data) == "cdefghij");
+    assert(fast.lag() == 0 && slow.lag() == 8);
+    assert(stream.current_buffer_size() == 8);
+    const auto read4 = slow.read(3, 3, NO_WAIT);
+    assert(read4 && text(read4.data) == "cde" && read4.buffer_size == 5);
+    assert(stream.current_buffer_size() == 5);
+    const auto read5 = slow.read(1, SIZE_MAX, NO_WAIT);
+    assert(read5 && text(read5.data) == "fghij");
+    assert(stream.current_buffer_size() == 0);
+    const auto read6 = slow.read(1, SIZE_MAX, NO_WAIT);
+    assert(read6.error == ErrorCode::Timeout && read6.data.empty());
+  }
+
+  // Test 16
+  {
+    // Evict skips the oldest bytes and reports them on the next read.
+    BroadcastStream stream(broadcast_options(LagPolicy::Evict, 8));
+    auto reader = stream.subscribe();
+    const auto error1 = stream.add_data(bytes("abcdef"));
+    const auto error2 = stream.add_data(bytes("ghij"));
+    assert(error1 == ErrorCode::NoError && error2 == ErrorCode::NoError);
+    assert(reader.lag() == 8);
+    const auto read1 = reader.read(1, SIZE_MAX, NO_WAIT);
+    assert(read1 && text(read1.data) == "cdefghij");
+    assert(read1.dropped_bytes == 2);
+    const auto error3 = stream.add_data(bytes("k"));
+    assert(error3 == ErrorCode::NoError);
+    const auto read2 = reader.read(1, SIZE_MAX, NO_WAIT);
+    assert(read2 && text(read2.data) == "k" && read2.dropped_bytes == 0);
+
+    const auto oversized = stream.add_data(bytes("123456789"));
+    assert(oversized == ErrorCode::BufferOverflow);
+  }
+
+  // Test 17
+  {
+    // Flag fails the first read after an eviction, then resumes.
+    BroadcastStream stream(broadcast_options(LagPolicy::Flag, 8));
+    auto reader = stream.subscribe();
+    const auto error1 = stream.add_data(bytes("abcdef"));
+    const auto error2 = stream.add_data(bytes("ghij"));
+    assert(error1 == ErrorCode::NoError && error2 == ErrorCode::NoError);
+    const auto flagged = reader.read(1, SIZE_MAX, LONG_WAIT);
+    assert(flagged.error == ErrorCode::BufferOverflow);
+    assert(flagged.data.empty() && flagged.dropped_bytes == 2);
+    assert(flagged.buffer_size == 8);
+    const auto resumed = reader.read(1, SIZE_MAX, NO_WAIT);
+    assert(resumed && text(resumed.data) == "cdefghij");
+    assert(resumed.dropped_bytes == 0);
+  }
+
+  // Test 18
+  {
+    // A Block producer waits for the slow consumer to read.
+    BroadcastStream stream(broadcast_options(LagPolicy::Block, 8));
+    auto reader = stream.subscribe();
+    const auto error1 = stream.add_data(bytes("abcdefgh"));
+    assert(error1 == ErrorCode::NoError);
+    ErrorCode error2 = ErrorCode::Timeout;
+    const auto start = std::chrono::steady_clock::now();
+    std::thread producer(
+        [&stream, &error2] { error2 = stream.add_data(bytes("ij")); });
+    std::this_thread::sleep_for(SHORT_WAIT);
+    const auto read1 = reader.read(2, 2, NO_WAIT);
+    assert(read1 && text(read1.data) == "ab");
+    producer.join();
+    // Released by the read, not by the block timeout.
+    assert(std::chrono::steady_clock::now() - start < LONG_WAIT);
+    assert(error2 == ErrorCode::NoError);
+    const auto read2 = reader.read(1, SIZE_MAX, NO_WAIT);
+    assert(read2 && text(read2.data) == "cdefghij");
+  }
+
+  // Test 19
+  {
+    // Unsubscribing the slow consumer also releases a Block producer.
+    BroadcastStream stream(broadcast_options(LagPolicy::Block, 8));
+    auto fast = stream.subscribe();
+    ErrorCode error2 = ErrorCode::Timeout;
+    const auto start = std::chrono::steady_clock::now();
+    std::thread producer;
+    {
+      auto slow = stream.subscribe();
+      const auto error1 = stream.add_data(bytes("abcdefgh"));
+      assert(error1 == ErrorCode::NoError);
+      const auto read1 = fast.read(1, SIZE_MAX, NO_WAIT);
+      assert(read1 && text(read1.data) == "abcdefgh");
+      producer = std::thread(
+          [&stream, &error2] { error2 = stream.add_data(bytes("ij")); });
+      std::this_thread::sleep_for(SHORT_WAIT);
+    }
+    producer.join();
+    assert(std::chrono::steady_clock::now() - start < LONG_WAIT);
+    assert(error2 == ErrorCode::NoError);
+    assert(stream.consumer_count() == 1);
+    assert(stream.current_buffer_size() == 2);
+
+    // After a stop the buffered data is still read, flagged.
+    stream.stop();
+    const auto stopped = stream.add_data(bytes("x"));
+    assert(stopped == ErrorCode::ControllerStopped);
+    const auto read2 = fast.read(1, SIZE_MAX, NO_WAIT);
+    assert(read2.error == ErrorCode::ControllerStopped);
+    assert(text(read2.data) == "ij");
+  }
+
+  std::cout << "All tests passed!\n";
+}
+
+int main() {
+  runTests();
+  return 0;
+}
@@ -0,0 +1,246 @@
+#include "../include/broadcast_stream.hpp"
+
+#include <algorithm>
+#include <utility>
+
+struct BroadcastStream::Cursor {
+  size_t position = 0;  ///< Stream offset of the next byte to read
+  size_t dropped = 0;   ///< Bytes evicted since the previous read
+  bool lagged = false;  ///< Evicted under LagPolicy::Flag, not reported
+};
+
+BroadcastStream::Consumer::Consumer(BroadcastStream* stream,
+                                    Cursor* cursor) noexcept
+    : stream_(stream), cursor_(cursor) {}
+
+BroadcastStream::Consumer::Consumer(Consumer&& other) noexcept
+    : stream_(std::exchange(other.stream_, nullptr)),
+      cursor_(std::exchange(other.cursor_, nullptr)) {}
+
+BroadcastStream::Consumer& BroadcastStream::Consumer::operator=(
+    Consumer&& other) noexcept {
+  if (this != &other) {
+    reset();
+    stream_ = std::exchange(other.stream_, nullptr);
+    cursor_ = std::exchange(other.cursor_, nullptr);
+  }
+  return *this;
+}
+
+BroadcastStream::Consumer::~Consumer() { reset(); }
+
+void BroadcastStream::Consumer::reset() noexcept {
+  if (stream_ != nullptr) {
+    stream_->unsubscribe(cursor_);
+  }
+  stream_ = nullptr;
+  cursor_ = nullptr;
+}
+
+BroadcastStream::Result BroadcastStream::Consumer::read(
+    size_t min_bytes, size_t max_bytes, std::chrono::milliseconds timeout) {
+  if (stream_ == nullptr) {
+    return Result{{}, ErrorCode::InvalidArgs, 0, 0, {}};
+  }
+  return stream_->read(*cursor_, min_bytes, max_bytes, timeout);
+}
+
+size_t BroadcastStream::Consumer::lag() const {
+  if (stream_ == nullptr) {
+    return 0;
+  }
+  const std::scoped_lock lock(stream_->mutex_);
+  return stream_->written_ - cursor_->position;
+}
+
+BroadcastStream::BroadcastStream(size_t max_buffer_size)
+    : BroadcastStream(Options{max_buffer_size}) {}
+
+BroadcastStream::BroadcastStream(const Options& options)
+    : max_lag_(options.max_lag == 0
+                   ? options.max_buffer_size
+                   : std::min(options.max_lag, options.max_buffer_size)),
+      lag_policy_(options.lag_policy),
+      block_timeout_(options.block_timeout),
+      storage_(ByteRing::storage_size(options.max_buffer_size)) {}
+
+BroadcastStream::~BroadcastStream() { stop(); }
+
+void BroadcastStream::stop() {
+  {
+    const std::scoped_lock lock(mutex_);
+    stopped_ = true;
+  }
+  cv_.notify_all();
+  producer_cv_.notify_all();
+}
+
+void BroadcastStream::start() {
+  const std::scoped_lock lock(mutex_);
+  stopped_ = false;
+}
+
+BroadcastStream::ErrorCode BroadcastStream::add_data(ByteSpan data) {
+  if (data.size() > max_lag_) {
+    return ErrorCode::BufferOverflow;
+  }
+
+  bool wake = false;
+  {
+    std::unique_lock lock(mutex_);
+    if (stopped_) {
+      return ErrorCode::ControllerStopped;
+    }
+
+    if (lag_policy_ == LagPolicy::Block) {
+      ++blocked_producers_;
+      const bool ready =
+          producer_cv_.wait_for(lock, block_timeout_, [this, &data] {
+            return stopped_ || fits(data.size());
+          });
+      --blocked_producers_;
+      if (stopped_) {
+        return ErrorCode::ControllerStopped;
+      }
+      if (!ready) {
+        return ErrorCode::BufferOverflow;
+      }
+    } else {
+      evict_lagging(data.size());
+    }
+
+    copy_in(written_, data);
+    written_ += data.size();
+    wake = sleeping_consumers_ > 0;
+  }
+
+  // Every consumer wants the new data.
+  if (wake) {
+    cv_.notify_all();
+  }
+  return ErrorCode::NoError;
+}
+
+BroadcastStream::Consumer BroadcastStream::subscribe() {
+  const std::scoped_lock lock(mutex_);
+  cursors_.push_back(std::make_unique<Cursor>());
+  cursors_.back()->position = written_;
+  return Consumer(this, cursors_.back().get());
+}
+
+size_t BroadcastStream::consumer_count() const {
+  const std::scoped_lock lock(mutex_);
+  return cursors_.size();
+}
+
+size_t BroadcastStream::current_buffer_size() const {
+  const std::scoped_lock lock(mutex_);
+  size_t lag = 0;
+  for (const auto& cursor : cursors_) {
+    lag = std::max(lag, written_ - cursor->position);
+  }
+  return lag;
+}
+
+bool BroadcastStream::is_stopped() const {
+  const std::scoped_lock lock(mutex_);
+  return stopped_;
+}
+
+bool BroadcastStream::fits(size_t bytes) const noexcept {
+  return std::ranges::all_of(cursors_, [this, bytes](const auto& cursor) {
+    return written_ - cursor->position + bytes <= max_lag_;
+  });
+}
+
+void BroadcastStream::evict_lagging(size_t bytes) {
+  // Positions wrap around, so only their distances are compared.
+  for (const auto& cursor : cursors_) {
+    const size_t lag = written_ - cursor->position + bytes;
+    if (lag <= max_lag_) {
+      continue;
+    }
+    cursor->dropped += lag - max_lag_;
+    cursor->position += lag - max_lag_;
+    cursor->lagged = lag_policy_ == LagPolicy::Flag;
+  }
+}
+
+void BroadcastStream::copy_in(size_t position, ByteSpan data) {
+  const size_t offset = position & (storage_.size() - 1);
+  const size_t head = std::min(data.size(), storage_.size() - offset);
+  std::ranges::copy(data.first(head), storage_.begin() + offset);
+  std::ranges::copy(data.subspan(head), storage_.begin());
+}
+
+void BroadcastStream::copy_out(size_t position, std::span<Byte> out) const {
+  const size_t offset = position & (storage_.size() - 1);
+  const size_t head = std::min(out.size(), storage_.size() - offset);
+  const auto tail =
+      std::ranges::copy_n(storage_.begin() + offset, head, out.begin()).out;
+  std::ranges::copy_n(storage_.begin(), out.size() - head, tail);
+}
+
+BroadcastStream::Result BroadcastStream::read(
+    Cursor& cursor, size_t min_bytes, size_t max_bytes,
+    std::chrono::milliseconds timeout) {
+  if (min_bytes > max_bytes) {
+    return Result{{}, ErrorCode::InvalidArgs, 0, 0, {}};
+  }
+
+  bool wake = false;
+  Result result{};
+  {
+    std::unique_lock lock(mutex_);
+    ++sleeping_consumers_;
+    const bool ready = cv_.wait_for(lock, timeout, [&] {
+      return stopped_ || cursor.lagged ||
+             written_ - cursor.position >= min_bytes;
+    });
+    --sleeping_consumers_;
+
+    const size_t available = written_ - cursor.position;
+    result.dropped_bytes = std::exchange(cursor.dropped, 0);
+    if (cursor.lagged) {
+      cursor.lagged = false;
+      result.error = ErrorCode::BufferOverflow;
+      result.buffer_size = available;
+      return result;
+    }
+    if (!ready) {
+      result.error = ErrorCode::Timeout;
+      result.buffer_size = available;
+      return result;
+    }
+
+    const size_t taken = std::min(available, max_bytes);
+    result.data.resize(taken);
+    copy_out(cursor.position, result.data);
+    cursor.position += taken;
+    result.buffer_size = available - taken;
+    if (stopped_) {
+      result.error = ErrorCode::ControllerStopped;
+    }
+    wake = taken > 0 && blocked_producers_ > 0;
+  }
+
+  // This consumer may have been the one holding producers back.
+  if (wake) {
+    producer_cv_.notify_all();
+  }
+  return result;
+}
+
+void BroadcastStream::unsubscribe(Cursor* cursor) {
+  bool wake = false;
+  {
+    const std::scoped_lock lock(mutex_);
+    std::erase_if(cursors_, [cursor](const std::unique_ptr<Cursor>& entry) {
+      return entry.get() == cursor;
+    });
+    wake = blocked_producers_ > 0;
+  }
+  if (wake) {
+    producer_cv_.notify_all();
+  }
+}
@@ -0,0 +1,91 @@
+#include "../include/byte_ring.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+
+ByteRing::ByteRing(size_t capacity)
+    : capacity_(capacity),
+      mask_(storage_size(capacity) - 1),
+      owned_(std::make_unique_for_overwrite<Byte[]>(mask_ + 1)),
+      data_(owned_.get()) {}
+
+ByteRing::ByteRing(Byte* storage, size_t capacity) noexcept
+    : capacity_(capacity), mask_(storage_size(capacity) - 1), data_(storage) {}
+
+size_t ByteRing::storage_size(size_t capacity) noexcept {
+  return std::bit_ceil(std::max<size_t>(capacity, 1));
+}
+
+bool ByteRing::try_push(std::span<const Byte> data) noexcept {
+  const size_t head = head_.load(std::memory_order_relaxed);
+
+  if (head - cached_tail_ + data.size() > capacity_) {
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+    if (head - cached_tail_ + data.size() > capacity_) {
+      return false;
+    }
+  }
+
+  if (data.empty()) {
+    return true;
+  }
+
+  const size_t offset = head & mask_;
+  const size_t first = std::min(data.size(), mask_ + 1 - offset);
+  std::memcpy(data_ + offset, data.data(), first);
+  std::memcpy(data_, data.data() + first, data.size() - first);
+
+  head_.store(head + data.size(), std::memory_order_release);
+  return true;
+}
+
+std::array<std::span<ByteRing::Byte>, 2> ByteRing::writable(
+    size_t max_bytes) noexcept {
+  const size_t head = head_.load(std::memory_order_relaxed);
+
+  if (capacity_ - (head - cached_tail_) < max_bytes) {
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+  }
+
+  const size_t count = std::min(max_bytes, capacity_ - (head - cached_tail_));
+  const size_t offset = head & mask_;
+  const size_t first = std::min(count, mask_ + 1 - offset);
+
+  return {std::span<Byte>(data_ + offset, first),
+          std::span<Byte>(data_, count - first)};
+}
+
+void ByteRing::commit(size_t count) noexcept {
+  const size_t head = head_.load(std::memory_order_relaxed);
+  const size_t free_space =
+      capacity_ - (head - tail_.load(std::memory_order_acquire));
+  head_.store(head + std::min(count, free_space), std::memory_order_release);
+}
+
+std::array<std::span<const ByteRing::Byte>, 2> ByteRing::readable(
+    size_t max_bytes) noexcept {
+  const size_t tail = tail_.load(std::memory_order_relaxed);
+
+  if (cached_head_ - tail < max_bytes) {
+    cached_head_ = head_.load(std::memory_order_acquire);
+  }
+
+  const size_t count = std::min(max_bytes, cached_head_ - tail);
+  const size_t offset = tail & mask_;
+  const size_t first = std::min(count, mask_ + 1 - offset);
+
+  return {std::span<const Byte>(data_ + offset, first),
+          std::span<const Byte>(data_, count - first)};
+}
+
+void ByteRing::consume(size_t count) noexcept {
+  const size_t tail = tail_.load(std::memory_order_relaxed);
+  const size_t available = head_.load(std::memory_order_acquire) - tail;
+  const size_t new_tail = tail + std::min(count, available);
+  // Keep the cached head from falling behind when the caller evicts more
+  // than it last observed.
+  cached_head_ = std::max(cached_head_, new_tail);
+  tail_.store(new_tail, std::memory_order_release);
+}
@@ -0,0 +1,144 @@
+#include "../include/crc32c.hpp"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define CRC32C_X86 1
+#elif defined(_M_X64)
+#include <intrin.h>
+#include <nmmintrin.h>
+#define CRC32C_X86 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CRC32C_ARM 1
+#endif
+
+namespace {
+
+using Byte = std::byte;
+
+constexpr uint32_t POLYNOMIAL = 0x82f63b78;  // Castagnoli, reflected
+
+constexpr std::array<uint32_t, 256> make_table() {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t i = 0; i < table.size(); ++i) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ ((crc & 1) != 0 ? POLYNOMIAL : 0);
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+constexpr std::array<uint32_t, 256> CRC_TABLE = make_table();
+
+// Works on the raw (non-inverted) register. Every byte is stored to dst
+// as it is folded in, so the data is read once.
+template <bool Copy>
+uint32_t table_loop(uint32_t crc, Byte* dst, const Byte* src, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    const Byte byte = src[i];
+    if constexpr (Copy) {
+      dst[i] = byte;
+    }
+    const uint32_t index = (crc ^ std::to_integer<uint32_t>(byte)) & 0xff;
+    crc = CRC_TABLE[index] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+// A null dst skips the copy.
+uint32_t table_update(uint32_t crc, Byte* dst, const Byte* src, size_t size) {
+  return dst != nullptr ? table_loop<true>(crc, dst, src, size)
+                        : table_loop<false>(crc, dst, src, size);
+}
+
+#if defined(CRC32C_X86)
+#if defined(__GNUC__) || defined(__clang__)
+#define CRC32C_HW_TARGET __attribute__((target("sse4.2")))
+#else
+#define CRC32C_HW_TARGET
+#endif
+
+CRC32C_HW_TARGET uint32_t hw_update(uint32_t crc, Byte* dst, const Byte* src,
+                                    size_t size) {
+  uint64_t crc64 = crc;
+  for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t)) {
+    uint64_t word = 0;
+    std::memcpy(&word, src, sizeof(word));
+    if (dst != nullptr) {
+      std::memcpy(dst, &word, sizeof(word));
+      dst += sizeof(word);
+    }
+    crc64 = _mm_crc32_u64(crc64, word);
+    src += sizeof(word);
+  }
+  auto crc32 = static_cast<uint32_t>(crc64);
+  for (; size > 0; --size) {
+    const auto byte = std::to_integer<uint8_t>(*src);
+    if (dst != nullptr) {
+      *dst++ = *src;
+    }
+    crc32 = _mm_crc32_u8(crc32, byte);
+    ++src;
+  }
+  return crc32;
+}
+
+bool hw_available() {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_cpu_supports("sse4.2");
+#else
+  std::array<int, 4> info{};
+  __cpuid(info.data(), 1);
+  return (info[2] & (1 << 20)) != 0;
+#endif
+}
+#elif defined(CRC32C_ARM)
+uint32_t hw_update(uint32_t crc, Byte* dst, const Byte* src, size_t size) {
+  for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t)) {
+    uint64_t word = 0;
+    std::memcpy(&word, src, sizeof(word));
+    if (dst != nullptr) {
+      std::memcpy(dst, &word, sizeof(word));
+      dst += sizeof(word);
+    }
+    crc = __crc32cd(crc, word);
+    src += sizeof(word);
+  }
+  for (; size > 0; --size) {
+    if (dst != nullptr) {
+      *dst++ = *src;
+    }
+    crc = __crc32cb(crc, std::to_integer<uint8_t>(*src));
+    ++src;
+  }
+  return crc;
+}
+
+bool hw_available() { return true; }
+#endif
+
+uint32_t update(uint32_t crc, Byte* dst, const Byte* src, size_t size) {
+#if defined(CRC32C_X86) || defined(CRC32C_ARM)
+  static const bool hardware = hw_available();
+  if (hardware) {
+    return ~hw_update(~crc, dst, src, size);
+  }
+#endif
+  return ~table_update(~crc, dst, src, size);
+}
+
+}  // namespace
+
+uint32_t crc32c_extend(uint32_t crc, std::span<const std::byte> data) noexcept {
+  return update(crc, nullptr, data.data(), data.size());
+}
+
+uint32_t crc32c_copy(uint32_t crc, std::byte* dst,
+                     std::span<const std::byte> src) noexcept {
+  return update(crc, dst, src.data(), src.size());
+}
@@ -1,20 +1,24 @@
+#include <algorithm>
 #include <chrono>
 #include <cstddef>
 #include <functional>
 #include <iostream>
 #include <thread>
-#include <vector>
 
 #include "../include/async_controller.hpp"
 
-static void device_simulation(const ByteStreamController::Callback& callback,
+static void device_simulation(ByteStreamController& controller,
                               bool& running) {
   for (size_t i = 0; i < ByteStreamController::DEFAULT_DEVICE_ITERATIONS; ++i) {
     if (!running) break;
 
-    std::vector<std::byte> data(ByteStreamController::DEFAULT_DEVICE_DATA_SIZE,
-                                static_cast<std::byte>(i));
-    callback(data);
+    // Write the packet straight into the controller's storage.
+    auto packet =
+        controller.reserve(ByteStreamController::DEFAULT_DEVICE_DATA_SIZE);
+    if (!packet.empty()) {
+      std::ranges::fill(packet, static_cast<std::byte>(i));
+      controller.commit(packet.size());
+    }
     std::this_thread::sleep_for(ByteStreamController::DEFAULT_DEVICE_DELAY);
   }
   running = false;
@@ -26,8 +30,7 @@ int main() {
 
   const std::chrono::milliseconds timeout(200);
 
-  auto device_callback = controller.get_callback();
-  std::thread device_thread(device_simulation, std::cref(device_callback),
+  std::thread device_thread(device_simulation, std::ref(controller),
                             std::ref(device_running));
 
   while (device_running || controller.current_buffer_size() > 0) {
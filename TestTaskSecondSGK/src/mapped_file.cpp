@@ -0,0 +1,119 @@
+#include "../include/mapped_file.hpp"
+
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace {
+
+std::error_code last_error() noexcept {
+#if defined(_WIN32)
+  return {static_cast<int>(GetLastError()), std::system_category()};
+#else
+  return {errno, std::system_category()};
+#endif
+}
+
+}  // namespace
+
+std::expected<MappedFile, std::error_code> MappedFile::create(
+    const std::filesystem::path& path, size_t size) {
+  if (size == 0) {
+    return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+  }
+
+#if defined(_WIN32)
+  HANDLE file = CreateFileW(
+      path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+      FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return std::unexpected(last_error());
+  }
+
+  const auto length = static_cast<unsigned long long>(size);
+  HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE,
+                                      static_cast<DWORD>(length >> 32),
+                                      static_cast<DWORD>(length), nullptr);
+  if (mapping == nullptr) {
+    const std::error_code error = last_error();
+    CloseHandle(file);
+    return std::unexpected(error);
+  }
+
+  void* data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+  const std::error_code error = last_error();
+  // The view keeps the mapping object alive.
+  CloseHandle(mapping);
+  if (data == nullptr) {
+    CloseHandle(file);
+    return std::unexpected(error);
+  }
+  return MappedFile(static_cast<Byte*>(data), size, file);
+#else
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+                        0600);
+  if (fd < 0) {
+    return std::unexpected(last_error());
+  }
+
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    const std::error_code error = last_error();
+    ::close(fd);
+    ::unlink(path.c_str());
+    return std::unexpected(error);
+  }
+
+  void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  const std::error_code error = last_error();
+  // The mapping keeps the file alive; nobody else needs to find it.
+  ::close(fd);
+  ::unlink(path.c_str());
+  if (data == MAP_FAILED) {
+    return std::unexpected(error);
+  }
+  return MappedFile(static_cast<Byte*>(data), size, nullptr);
+#endif
+}
+
+MappedFile::MappedFile(Byte* data, size_t size, void* handle) noexcept
+    : data_(data), size_(size), handle_(handle) {}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      handle_(std::exchange(other.handle_, nullptr)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    reset();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    handle_ = std::exchange(other.handle_, nullptr);
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() { reset(); }
+
+void MappedFile::reset() noexcept {
+  if (data_ == nullptr) {
+    return;
+  }
+#if defined(_WIN32)
+  UnmapViewOfFile(data_);
+  CloseHandle(static_cast<HANDLE>(handle_));
+#else
+  ::munmap(data_, size_);
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  handle_ = nullptr;
+}
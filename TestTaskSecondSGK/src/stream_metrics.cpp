@@ -0,0 +1,86 @@
+#include "../include/stream_metrics.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+// Hands out shards round-robin in the order threads first touch metrics.
+std::atomic<size_t> next_shard{0};
+
+void bump(std::atomic<uint64_t>& counter, uint64_t value) noexcept {
+  counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+StreamMetrics::Shard& StreamMetrics::local_shard() noexcept {
+  thread_local const size_t index =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % SHARD_COUNT;
+  return shards_[index];
+}
+
+void StreamMetrics::add_in(size_t bytes) noexcept {
+  if (bytes > 0) {
+    bump(local_shard().bytes_in, bytes);
+  }
+}
+
+void StreamMetrics::add_out(size_t bytes) noexcept {
+  if (bytes > 0) {
+    bump(local_shard().bytes_out, bytes);
+  }
+}
+
+void StreamMetrics::add_dropped(DropReason reason, size_t bytes) noexcept {
+  if (bytes > 0) {
+    bump(local_shard().dropped_bytes[static_cast<size_t>(reason)], bytes);
+  }
+}
+
+void StreamMetrics::add_read(std::chrono::nanoseconds waited) noexcept {
+  const auto micros = static_cast<uint64_t>(std::max<int64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(waited).count(),
+      0));
+  const size_t bucket =
+      std::min<size_t>(std::bit_width(micros), WAIT_BUCKET_COUNT - 1);
+
+  Shard& shard = local_shard();
+  bump(shard.reads, 1);
+  bump(shard.wait_histogram[bucket], 1);
+}
+
+void StreamMetrics::add_read_timeout() noexcept {
+  bump(local_shard().read_timeouts, 1);
+}
+
+void StreamMetrics::observe_size(size_t size) noexcept {
+  // Only a new maximum writes the shared line.
+  size_t seen = high_water_mark_.load(std::memory_order_relaxed);
+  while (size > seen && !high_water_mark_.compare_exchange_weak(
+                            seen, size, std::memory_order_relaxed)) {
+  }
+}
+
+StreamMetrics::Snapshot StreamMetrics::snapshot() const noexcept {
+  Snapshot result;
+  for (const Shard& shard : shards_) {
+    result.bytes_in += shard.bytes_in.load(std::memory_order_relaxed);
+    result.bytes_out += shard.bytes_out.load(std::memory_order_relaxed);
+    result.reads += shard.reads.load(std::memory_order_relaxed);
+    result.read_timeouts +=
+        shard.read_timeouts.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < DROP_REASON_COUNT; ++i) {
+      result.dropped_bytes[i] +=
+          shard.dropped_bytes[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < WAIT_BUCKET_COUNT; ++i) {
+      result.wait_histogram[i] +=
+          shard.wait_histogram[i].load(std::memory_order_relaxed);
+    }
+  }
+  result.high_water_mark = high_water_mark_.load(std::memory_order_relaxed);
+  return result;
+}